@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gdsrecordframer.h"
+
+namespace q5250 {
+
+namespace {
+const int GdsHeaderLength = 10;
+const int GdsRecordType = 0x12a0;
+
+// record length and record type are enough to validate a header
+const int ValidatedHeaderLength = 4;
+}
+
+GdsRecordFramer::GdsRecordFramer() :
+    expectedLength(0)
+{
+}
+
+// Calls handler for each complete record in data. Returns false
+// if the data contained a malformed header and was dropped.
+bool GdsRecordFramer::frame(const QByteArray &data, const RecordHandler &handler)
+{
+    const char *input = data.constData();
+    int remaining = data.size();
+
+    while (remaining > 0) {
+        if (pending.isEmpty() && remaining >= ValidatedHeaderLength) {
+            if (!isValidHeader(input)) {
+                reset();
+                return false;
+            }
+
+            int length = recordLength(input);
+            if (length <= remaining) {
+                handler(QByteArray::fromRawData(input, length));
+                input += length;
+                remaining -= length;
+                continue;
+            }
+
+            expectedLength = length;
+            pending.reserve(length);
+        }
+
+        int missing = expectedLength > 0 ? expectedLength - pending.size()
+                                         : ValidatedHeaderLength - pending.size();
+        int size = qMin(missing, remaining);
+        pending.append(input, size);
+        input += size;
+        remaining -= size;
+
+        if (expectedLength == 0 && pending.size() == ValidatedHeaderLength) {
+            if (!isValidHeader(pending.constData())) {
+                reset();
+                return false;
+            }
+            expectedLength = recordLength(pending.constData());
+            pending.reserve(expectedLength);
+        }
+
+        if (expectedLength > 0 && pending.size() == expectedLength) {
+            handler(pending);
+            reset();
+        }
+    }
+
+    return true;
+}
+
+void GdsRecordFramer::reset()
+{
+    pending.clear();
+    expectedLength = 0;
+}
+
+bool GdsRecordFramer::isValidHeader(const char *header)
+{
+    return recordLength(header) >= GdsHeaderLength &&
+           (((uchar)header[2] << 8) | (uchar)header[3]) == GdsRecordType;
+}
+
+int GdsRecordFramer::recordLength(const char *header)
+{
+    return ((uchar)header[0] << 8) | (uchar)header[1];
+}
+
+} // namespace q5250
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_GDSRECORDFRAMER_H
+#define Q5250_GDSRECORDFRAMER_H
+
+#include "q5250_global.h"
+
+#include <functional>
+#include <QByteArray>
+
+namespace q5250 {
+
+/*
+ * Splits received data into GDS records by the record length in
+ * their header, independent of how the data was split into chunks.
+ *
+ * Records that are complete within a chunk are handed out as views
+ * into the chunk. A record that continues in the next chunk is
+ * collected in a buffer that is allocated once with the record length.
+ * A header with a record length shorter than the header or with a
+ * wrong record type makes the rest of the data undecodable, so it
+ * is dropped.
+ */
+class Q5250SHARED_EXPORT GdsRecordFramer
+{
+public:
+    typedef std::function<void (const QByteArray &record)> RecordHandler;
+
+    GdsRecordFramer();
+
+    bool frame(const QByteArray &data, const RecordHandler &handler);
+    void reset();
+
+    int pendingRecordSize() const { return pending.size(); }
+
+private:
+    static bool isValidHeader(const char *header);
+    static int recordLength(const char *header);
+
+    QByteArray pending;
+    int expectedLength;
+};
+
+} // namespace q5250
+
+#endif // Q5250_GDSRECORDFRAMER_H
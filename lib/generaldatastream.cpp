@@ -25,164 +25,90 @@
  */
 #include "generaldatastream.h"
 
-#include <QDataStream>
-#include <QScopedPointer>
-
 namespace q5250 {
 
-class GeneralDataStream::Private
-{
-public:
-    struct Header
-    {
-        quint16 recordLength;
-        quint16 recordType;
-        quint16 reservedBytes;
-        quint8 varHdrLen;
-        quint16 flags;
-        quint8 opcode;
-    };
-
-    QByteArray writeBuffer;
-    QScopedPointer<QDataStream> stream;
-    Header header;
-    static const quint16 GdsRecordType{0x12a0};
-    static const qint64 GdsHeaderLength{10};
-
-    Private();
-    explicit Private(const QByteArray &data);
-    void readHeader();
-    QByteArray addHeaderToBuffer(const QByteArray &buffer);
-
-    bool isValid() const;
-    bool atStart() const;
-
-    qint64 currentPosition() const;
-    void seekToPosition(qint64 pos);
-};
-
-GeneralDataStream::Private::Private() :
-    stream(new QDataStream(&writeBuffer, QIODevice::WriteOnly))
-{
-}
-
-GeneralDataStream::Private::Private(const QByteArray &data) :
-    stream(new QDataStream(data))
-{
-    readHeader();
-}
-
-void GeneralDataStream::Private::readHeader()
-{
-    *stream >> header.recordLength
-            >> header.recordType
-            >> header.reservedBytes
-            >> header.varHdrLen
-            >> header.flags
-            >> header.opcode;
-}
-
-QByteArray GeneralDataStream::Private::addHeaderToBuffer(const QByteArray &buffer)
-{
-    quint16 streamLength = GdsHeaderLength + buffer.size();
-
-    QByteArray gdsData;
-    QDataStream gds(&gdsData, QIODevice::WriteOnly);
-
-    gds << streamLength;
-    gds << GdsRecordType;
-    gds << (quint16)0x0000;     // reserved
-    gds << (quint8)0x04;        // variable header length
-    gds << (quint16)0x0000;     // flags
-    gds << (quint8)0x00;        // opcode
-
-    gdsData.append(buffer);
-
-    return gdsData;
-}
-
-bool GeneralDataStream::Private::isValid() const
+static quint16 wordAt(const unsigned char *data)
 {
-    return header.recordLength == stream->device()->size() &&
-           header.recordType == GdsRecordType;
+    return (data[0] << 8) | data[1];
 }
 
-bool GeneralDataStream::Private::atStart() const
-{
-    return stream->device()->pos() == GdsHeaderLength;
-}
-
-qint64 GeneralDataStream::Private::currentPosition() const
-{
-    return stream->device()->pos();
-}
-
-void GeneralDataStream::Private::seekToPosition(qint64 pos)
-{
-    stream->device()->seek(pos);
-}
-
-
 GeneralDataStream::GeneralDataStream() :
-    d(new Private())
-{
+    begin(nullptr),
+    position(nullptr),
+    end(nullptr),
+    recordLength(0),
+    recordType(0),
+    readOnly(false)
+{
+    static const char header[GdsHeaderLength] {
+        0x00, 0x00,                         // record length, set by toByteArray()
+        char(GdsRecordType >> 8), char(GdsRecordType & 0xff),
+        0x00, 0x00,                         // reserved
+        0x04,                               // variable header length
+        0x00, 0x00,                         // flags
+        0x00                                // opcode
+    };
+
+    buffer.reserve(InitialWriteCapacity);
+    buffer.append(header, GdsHeaderLength);
 }
 
 GeneralDataStream::GeneralDataStream(const QByteArray &data) :
-    d(new Private(data))
+    buffer(data),
+    recordLength(0),
+    recordType(0),
+    readOnly(true)
 {
-}
+    const unsigned char *start = reinterpret_cast<const unsigned char*>(buffer.constData());
+    end = start + buffer.size();
 
-GeneralDataStream::~GeneralDataStream()
-{
-}
+    if (buffer.size() >= GdsHeaderLength) {
+        recordLength = wordAt(start);
+        recordType = wordAt(start + 2);
+        begin = start + GdsHeaderLength;
+    } else {
+        begin = end;
+    }
 
-bool GeneralDataStream::isValid() const
-{
-    return d->isValid();
+    position = begin;
 }
 
-bool GeneralDataStream::atEnd() const
+bool GeneralDataStream::isValid() const
 {
-    return d->stream->atEnd();
+    return readOnly &&
+           recordLength == buffer.size() &&
+           recordType == GdsRecordType;
 }
 
 QIODevice::OpenMode GeneralDataStream::openMode() const
 {
-    return d->stream->device()->openMode();
-}
-
-unsigned char GeneralDataStream::readByte()
-{
-    unsigned char byte;
-    *d->stream >> byte;
-    return byte;
+    return readOnly ? QIODevice::ReadOnly : QIODevice::WriteOnly;
 }
 
-unsigned short GeneralDataStream::readWord()
+void GeneralDataStream::reserve(int size)
 {
-    unsigned char highByte, lowByte;
-    *d->stream >> highByte >> lowByte;
-    return (highByte << 8) | lowByte;
+    buffer.reserve(GdsHeaderLength + size);
 }
 
-void GeneralDataStream::seekToPreviousByte()
+QByteArray GeneralDataStream::toByteArray()
 {
-    if (d->atStart())
-        return;
+    quint16 streamLength = buffer.size();
+    buffer[0] = char(streamLength >> 8);
+    buffer[1] = char(streamLength);
 
-    d->seekToPosition(d->currentPosition()-1);
+    return buffer;
 }
 
-QByteArray GeneralDataStream::toByteArray() const
+GeneralDataStream &GeneralDataStream::append(const char *data, size_t size)
 {
-    return d->addHeaderToBuffer(d->writeBuffer);
+    buffer.append(data, int(size));
+    return *this;
 }
 
-GeneralDataStream &GeneralDataStream::operator<<(quint8 byte)
+GeneralDataStream &GeneralDataStream::appendWord(quint16 word)
 {
-    *d->stream << byte;
-    return *this;
+    const char bytes[] { char(word >> 8), char(word) };
+    return append(bytes, sizeof(bytes));
 }
 
 } // namespace q5250
@@ -28,35 +28,89 @@
 
 #include "q5250_global.h"
 
-#include <memory>
+#include <QByteArray>
 #include <QIODevice>
+#include <type_traits>
 
 namespace q5250 {
 
+/*
+ * Reads or writes the data of a 5250 record with a GDS header.
+ *
+ * A stream created from a record reads directly from the record data
+ * between two pointers, the read functions are bounds checked and
+ * return 0 once the end of the record is reached.
+ *
+ * A default constructed stream writes a record. The header is reserved
+ * at the start of the buffer and its record length is filled in by
+ * toByteArray(), which hands out the buffer without copying it.
+ * clear() starts the next record in the same buffer.
+ */
 class Q5250SHARED_EXPORT GeneralDataStream
 {
 public:
     GeneralDataStream();
     explicit GeneralDataStream(const QByteArray &data);
-    ~GeneralDataStream();
 
     bool isValid() const;
-    bool atEnd() const;
+    bool atEnd() const { return position == end; }
     QIODevice::OpenMode openMode() const;
 
-    unsigned char readByte();
+    unsigned char readByte() { return position < end ? *position++ : 0; }
     unsigned short readWord();
-    void seekToPreviousByte();
+    unsigned char peekByte() const { return position < end ? *position : 0; }
+    void seekToPreviousByte() { if (position > begin) --position; }
+
+    const char *readPointer() const { return reinterpret_cast<const char*>(position); }
+    const char *endPointer() const { return reinterpret_cast<const char*>(end); }
+    void skip(int size) { position += qMin<qint64>(qMax(size, 0), end - position); }
+
+    void reserve(int size);
+    void clear() { buffer.resize(GdsHeaderLength); }
+    QByteArray toByteArray();
 
-    QByteArray toByteArray() const;
+    GeneralDataStream &operator<<(quint8 byte) { buffer.append(char(byte)); return *this; }
+    GeneralDataStream &append(const char *data, size_t size);
+    GeneralDataStream &appendWord(quint16 word);
 
-    GeneralDataStream &operator<<(quint8 byte);
+    // Appends a struct of single byte members, for example the
+    // row, column and order bytes of a SET BUFFER ADDRESS.
+    template<typename T>
+    GeneralDataStream &appendStruct(const T &data)
+    {
+        static_assert(std::is_pod<T>::value && alignof(T) == 1,
+                      "appendStruct() requires a struct of bytes");
+        return append(reinterpret_cast<const char*>(&data), sizeof(T));
+    }
 
 private:
-    class Private;
-    std::unique_ptr<Private> d;
+    Q_DISABLE_COPY(GeneralDataStream)
+
+    static const quint16 GdsRecordType{0x12a0};
+    static const int GdsHeaderLength{10};
+    static const int InitialWriteCapacity{256};
+
+    QByteArray buffer;
+    const unsigned char *begin;
+    const unsigned char *position;
+    const unsigned char *end;
+    quint16 recordLength;
+    quint16 recordType;
+    bool readOnly;
 };
 
+inline unsigned short GeneralDataStream::readWord()
+{
+    if (end - position < 2) {
+        position = end;
+        return 0;
+    }
+
+    unsigned short word = (position[0] << 8) | position[1];
+    position += 2;
+    return word;
+}
+
 } // namespace q5250
 
 #endif // Q5250_GENERALDATASTREAM_H
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_BASICTELNETPARSER_H
+#define Q5250_BASICTELNETPARSER_H
+
+#include <QByteArray>
+#include <QMetaType>
+
+#include "iacscanner.h"
+#include "subnegotiationcommand.h"
+#include "telnetcommand.h"
+#include "telnetoption.h"
+#include "telnetreceivebuffer.h"
+
+namespace q5250 {
+
+/*
+ * Streaming telnet parser that reports its results by directly calling
+ * the following methods of the handler:
+ *
+ *   void dataReceived(const QByteArray &data);
+ *   void optionNegotiationReceived(TelnetCommand command, TelnetOption option);
+ *   void subnegotiationReceived(TelnetOption option, SubnegotiationCommand command,
+ *                               const QByteArray &parameters);
+ *
+ * The data record passed to dataReceived() is a view into the receive
+ * buffer (see TelnetReceiveBuffer).
+ */
+template <typename Handler>
+class BasicTelnetParser
+{
+public:
+    explicit BasicTelnetParser(Handler &handler);
+
+    void parse(TelnetReceiveBuffer &buffer);
+
+private:
+    enum class State
+    {
+        Data,
+        InterpretAsCommand,
+        OptionNegotiation,
+        Subnegotiation,
+        SubnegotiationInterpretAsCommand
+    };
+
+    void parseDataRun(TelnetReceiveBuffer &buffer);
+    void parseByte(TelnetReceiveBuffer &buffer, unsigned char byte);
+    void parseCommand(TelnetReceiveBuffer &buffer, unsigned char byte);
+    void parseSubnegotiationCommand(unsigned char byte);
+    void subnegotiationReceived();
+
+    static bool isInterpretAsCommand(unsigned char byte);
+    static bool isOptionCommand(unsigned char byte);
+    static bool isSubnegotiationBeginCommand(unsigned char byte);
+    static bool isSubnegotiationEndCommand(unsigned char byte);
+    static bool isEndOfRecordCommand(unsigned char byte);
+
+    Handler &handler;
+    State state;
+    TelnetCommand optionCommand;
+    QByteArray subnegotiationData;
+};
+
+template <typename Handler>
+BasicTelnetParser<Handler>::BasicTelnetParser(Handler &handler) :
+    handler(handler),
+    state(State::Data),
+    optionCommand(TelnetCommand::NOP)
+{
+}
+
+template <typename Handler>
+void BasicTelnetParser<Handler>::parse(TelnetReceiveBuffer &buffer)
+{
+    // The parser keeps its state between calls, so records, commands and
+    // escaped IAC bytes may be split across several chunks of data. The
+    // record data is unescaped in place inside of the receive buffer.
+    while (!buffer.atEnd()) {
+        if (state == State::Data) {
+            parseDataRun(buffer);
+        } else {
+            parseByte(buffer, buffer.readByte());
+        }
+    }
+}
+
+template <typename Handler>
+void BasicTelnetParser<Handler>::parseDataRun(TelnetReceiveBuffer &buffer)
+{
+    // almost all bytes are plain data, so skip to the next IAC
+    // and move the whole run of data into the record at once
+    const char *run = buffer.readPointer();
+    const char *iac = findInterpretAsCommand(run, buffer.endPointer());
+
+    buffer.writeRun(iac - run);
+
+    if (!buffer.atEnd()) {
+        buffer.readByte();
+        state = State::InterpretAsCommand;
+    }
+}
+
+template <typename Handler>
+void BasicTelnetParser<Handler>::parseByte(TelnetReceiveBuffer &buffer, unsigned char byte)
+{
+    switch (state) {
+    case State::Data:
+        if (isInterpretAsCommand(byte)) {
+            state = State::InterpretAsCommand;
+        } else {
+            buffer.writeByte(byte);
+        }
+        break;
+
+    case State::InterpretAsCommand:
+        parseCommand(buffer, byte);
+        break;
+
+    case State::OptionNegotiation:
+        state = State::Data;
+        handler.optionNegotiationReceived(optionCommand, (TelnetOption)byte);
+        break;
+
+    case State::Subnegotiation:
+        if (isInterpretAsCommand(byte)) {
+            state = State::SubnegotiationInterpretAsCommand;
+        } else {
+            subnegotiationData.append((char)byte);
+        }
+        break;
+
+    case State::SubnegotiationInterpretAsCommand:
+        parseSubnegotiationCommand(byte);
+        break;
+    }
+}
+
+template <typename Handler>
+void BasicTelnetParser<Handler>::parseCommand(TelnetReceiveBuffer &buffer, unsigned char byte)
+{
+    // All TELNET commands consist of at least a two byte sequence:  the
+    // "Interpret as Command" (IAC) escape character followed by the code
+    // for the command.
+    if (isInterpretAsCommand(byte)) {
+        // escaped IAC is a data byte
+        buffer.writeByte(byte);
+        state = State::Data;
+    } else if (isEndOfRecordCommand(byte)) {
+        state = State::Data;
+        handler.dataReceived(buffer.takeRecord());
+    } else if (isOptionCommand(byte)) {
+        // The commands dealing with option negotiation are
+        // three byte sequences, the third byte being the code for the option
+        // referenced.
+        optionCommand = (TelnetCommand)byte;
+        state = State::OptionNegotiation;
+    } else if (isSubnegotiationBeginCommand(byte)) {
+        subnegotiationData.clear();
+        state = State::Subnegotiation;
+    } else {
+        // ignore all other commands (NOP, ...)
+        state = State::Data;
+    }
+}
+
+template <typename Handler>
+void BasicTelnetParser<Handler>::parseSubnegotiationCommand(unsigned char byte)
+{
+    if (isSubnegotiationEndCommand(byte)) {
+        state = State::Data;
+        subnegotiationReceived();
+    } else {
+        // escaped IAC inside of the subnegotiation parameters
+        if (isInterpretAsCommand(byte)) {
+            subnegotiationData.append((char)byte);
+        }
+        state = State::Subnegotiation;
+    }
+}
+
+template <typename Handler>
+void BasicTelnetParser<Handler>::subnegotiationReceived()
+{
+    // IAC SB <option> <command> [parameters] IAC SE
+    if (subnegotiationData.size() < 2) {
+        return;
+    }
+
+    handler.subnegotiationReceived((TelnetOption)subnegotiationData.at(0),
+                                   (SubnegotiationCommand)subnegotiationData.at(1),
+                                   subnegotiationData.mid(2));
+}
+
+template <typename Handler>
+bool BasicTelnetParser<Handler>::isInterpretAsCommand(unsigned char byte)
+{
+    return (TelnetCommand)byte == TelnetCommand::IAC;
+}
+
+template <typename Handler>
+bool BasicTelnetParser<Handler>::isOptionCommand(unsigned char byte)
+{
+    TelnetCommand command = (TelnetCommand)byte;
+    return command == TelnetCommand::WILL ||
+           command == TelnetCommand::WONT ||
+           command == TelnetCommand::DO   ||
+           command == TelnetCommand::DONT;
+}
+
+template <typename Handler>
+bool BasicTelnetParser<Handler>::isSubnegotiationBeginCommand(unsigned char byte)
+{
+    return (TelnetCommand)byte == TelnetCommand::SB;
+}
+
+template <typename Handler>
+bool BasicTelnetParser<Handler>::isSubnegotiationEndCommand(unsigned char byte)
+{
+    return (TelnetCommand)byte == TelnetCommand::SE;
+}
+
+template <typename Handler>
+bool BasicTelnetParser<Handler>::isEndOfRecordCommand(unsigned char byte)
+{
+    return (TelnetCommand)byte == TelnetCommand::EOR;
+}
+
+} // namespace q5250
+
+#endif // Q5250_BASICTELNETPARSER_H
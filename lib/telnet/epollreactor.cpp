@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "epollreactor.h"
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "epolltelnetconnection.h"
+
+namespace q5250 {
+
+static const int MaxEventsPerWait = 256;
+
+EpollReactor::EpollReactor() :
+    epollFd(epoll_create1(EPOLL_CLOEXEC)),
+    pendingEvents(nullptr),
+    pendingEventCount(0)
+{
+}
+
+EpollReactor::~EpollReactor()
+{
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+std::unique_ptr<NativeTelnetConnection> EpollReactor::createConnection()
+{
+    return std::unique_ptr<NativeTelnetConnection>(new EpollTelnetConnection(*this));
+}
+
+bool EpollReactor::add(int fd, quint32 events, Handler *handler)
+{
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = handler;
+
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool EpollReactor::modify(int fd, quint32 events, Handler *handler)
+{
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = handler;
+
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EpollReactor::remove(int fd, Handler *handler)
+{
+    epoll_event event;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, &event);
+
+    // the handler may be destroyed right after this call, so drop
+    // its events that are still waiting to be dispatched
+    for (int i = 0; i < pendingEventCount; ++i) {
+        if (pendingEvents[i].data.ptr == handler) {
+            pendingEvents[i].data.ptr = nullptr;
+        }
+    }
+}
+
+int EpollReactor::processEvents(int timeout)
+{
+    epoll_event events[MaxEventsPerWait];
+
+    int count = epoll_wait(epollFd, events, MaxEventsPerWait, timeout);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    pendingEvents = events;
+    pendingEventCount = count;
+
+    for (int i = 0; i < count; ++i) {
+        Handler *handler = static_cast<Handler*>(events[i].data.ptr);
+        if (handler) {
+            handler->handleEvents(events[i].events);
+        }
+    }
+
+    pendingEvents = nullptr;
+    pendingEventCount = 0;
+
+    return count;
+}
+
+} // namespace q5250
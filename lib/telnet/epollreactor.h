@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_EPOLLREACTOR_H
+#define Q5250_EPOLLREACTOR_H
+
+#include "q5250_global.h"
+
+#include <QtGlobal>
+
+#include "telnetreactor.h"
+
+struct epoll_event;
+
+namespace q5250 {
+
+/*
+ * Single threaded event loop on top of epoll (Linux only).
+ *
+ * One reactor drives any number of non-blocking sockets. Each registered
+ * file descriptor has a handler that is called with the epoll event mask
+ * whenever the descriptor becomes ready.
+ */
+class Q5250SHARED_EXPORT EpollReactor : public TelnetReactor
+{
+public:
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+        virtual void handleEvents(quint32 events) = 0;
+    };
+
+    EpollReactor();
+    ~EpollReactor();
+
+    bool add(int fd, quint32 events, Handler *handler);
+    bool modify(int fd, quint32 events, Handler *handler);
+    void remove(int fd, Handler *handler);
+
+    std::unique_ptr<NativeTelnetConnection> createConnection() Q_DECL_OVERRIDE;
+    int processEvents(int timeout) Q_DECL_OVERRIDE;
+
+private:
+    int epollFd;
+    epoll_event *pendingEvents;
+    int pendingEventCount;
+};
+
+} // namespace q5250
+
+#endif // Q5250_EPOLLREACTOR_H
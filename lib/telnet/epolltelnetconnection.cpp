@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "epolltelnetconnection.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QString>
+
+namespace q5250 {
+
+static const int ReadAllChunkSize = 4096;
+
+EpollTelnetConnection::EpollTelnetConnection(EpollReactor &reactor) :
+    reactor(reactor),
+    socketFd(-1),
+    state(State::Unconnected),
+    pendingOffset(0)
+{
+}
+
+EpollTelnetConnection::~EpollTelnetConnection()
+{
+    close();
+}
+
+bool EpollTelnetConnection::isConnected() const
+{
+    return state == State::Connected;
+}
+
+void EpollTelnetConnection::close()
+{
+    if (socketFd < 0) return;
+
+    reactor.remove(socketFd, this);
+    ::close(socketFd);
+
+    socketFd = -1;
+    state = State::Unconnected;
+    pendingData.clear();
+    pendingOffset = 0;
+}
+
+void EpollTelnetConnection::connectToHost(const QString &hostName, quint16 port)
+{
+    close();
+
+    // name resolution blocks, the connect itself does not
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(hostName.toLatin1().constData(), QByteArray::number(port).constData(), &hints, &addresses) != 0) {
+        return;
+    }
+
+    for (addrinfo *address = addresses; address; address = address->ai_next) {
+        int fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) continue;
+
+        // telnet records are small and latency bound
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0 || errno == EINPROGRESS) {
+            socketFd = fd;
+            break;
+        }
+
+        ::close(fd);
+    }
+
+    freeaddrinfo(addresses);
+
+    if (socketFd < 0) return;
+
+    state = State::Connecting;
+    reactor.add(socketFd, EPOLLOUT, this);
+}
+
+QByteArray EpollTelnetConnection::readAll()
+{
+    QByteArray data;
+
+    qint64 bytesRead;
+    do {
+        int size = data.size();
+        data.resize(size + ReadAllChunkSize);
+        bytesRead = read(data.data() + size, ReadAllChunkSize);
+        data.resize(size + qMax(bytesRead, qint64(0)));
+    } while (bytesRead == ReadAllChunkSize);
+
+    return data;
+}
+
+qint64 EpollTelnetConnection::read(char *data, qint64 maxSize)
+{
+    if (state != State::Connected) return -1;
+
+    ssize_t bytesRead = ::recv(socketFd, data, maxSize, 0);
+    if (bytesRead > 0) {
+        return bytesRead;
+    }
+
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+
+    // closed by the server or connection error
+    close();
+    return -1;
+}
+
+void EpollTelnetConnection::write(const QByteArray &data)
+{
+    if (socketFd < 0) return;
+
+    // keep the order of data queued while connecting or blocked
+    if (state != State::Connected || pendingOffset < pendingData.size()) {
+        pendingData.append(data);
+        return;
+    }
+
+    ssize_t bytesWritten = ::send(socketFd, data.constData(), data.size(), MSG_NOSIGNAL);
+    if (bytesWritten < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            close();
+            return;
+        }
+        bytesWritten = 0;
+    }
+
+    if (bytesWritten < data.size()) {
+        // data may be a raw view of the caller's reused buffer, so copy
+        // the tail (mid() would share the view when nothing was sent)
+        pendingData = QByteArray(data.constData() + bytesWritten, data.size() - bytesWritten);
+        pendingOffset = 0;
+        updateEvents();
+    }
+}
+
+void EpollTelnetConnection::handleEvents(quint32 events)
+{
+    if (state == State::Connecting) {
+        connectionEstablished();
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        writePendingData();
+    }
+
+    // errors and hang ups are reported by the next read()
+    if (socketFd >= 0 && (events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+        readyRead();
+    }
+}
+
+void EpollTelnetConnection::connectionEstablished()
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+        close();
+        return;
+    }
+
+    state = State::Connected;
+    writePendingData();
+
+    if (socketFd >= 0) {
+        connected();
+    }
+}
+
+void EpollTelnetConnection::writePendingData()
+{
+    while (pendingOffset < pendingData.size()) {
+        ssize_t bytesWritten = ::send(socketFd, pendingData.constData() + pendingOffset,
+                                      pendingData.size() - pendingOffset, MSG_NOSIGNAL);
+        if (bytesWritten < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            close();
+            return;
+        }
+        pendingOffset += bytesWritten;
+    }
+
+    if (pendingOffset == pendingData.size()) {
+        pendingData.clear();
+        pendingOffset = 0;
+    }
+
+    updateEvents();
+}
+
+void EpollTelnetConnection::updateEvents()
+{
+    quint32 events = EPOLLIN;
+    if (pendingOffset < pendingData.size()) {
+        events |= EPOLLOUT;
+    }
+
+    reactor.modify(socketFd, events, this);
+}
+
+} // namespace q5250
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_EPOLLTELNETCONNECTION_H
+#define Q5250_EPOLLTELNETCONNECTION_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+
+#include "epollreactor.h"
+#include "nativetelnetconnection.h"
+
+namespace q5250 {
+
+/*
+ * Telnet connection on a non-blocking socket driven by an EpollReactor.
+ *
+ * Unlike TcpSocketTelnetConnection there is no internal receive buffer:
+ * read() receives straight into the caller's buffer. Until the readyRead
+ * handler has read everything the reactor keeps reporting the socket
+ * as readable.
+ */
+class Q5250SHARED_EXPORT EpollTelnetConnection : public NativeTelnetConnection, private EpollReactor::Handler
+{
+public:
+    explicit EpollTelnetConnection(EpollReactor &reactor);
+    ~EpollTelnetConnection();
+
+    bool isConnected() const Q_DECL_OVERRIDE;
+    void close() Q_DECL_OVERRIDE;
+
+    void connectToHost(const QString &hostName, quint16 port) Q_DECL_OVERRIDE;
+
+    QByteArray readAll() Q_DECL_OVERRIDE;
+    qint64 read(char *data, qint64 maxSize) Q_DECL_OVERRIDE;
+    void write(const QByteArray &data) Q_DECL_OVERRIDE;
+
+private:
+    enum class State { Unconnected, Connecting, Connected };
+
+    void handleEvents(quint32 events) Q_DECL_OVERRIDE;
+    void connectionEstablished();
+    void writePendingData();
+    void updateEvents();
+
+    EpollReactor &reactor;
+    int socketFd;
+    State state;
+    QByteArray pendingData;
+    int pendingOffset;
+};
+
+} // namespace q5250
+
+#endif // Q5250_EPOLLTELNETCONNECTION_H
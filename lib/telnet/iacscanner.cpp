@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "iacscanner.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define Q5250_IACSCANNER_X86
+#include <immintrin.h>
+#endif
+
+namespace q5250 {
+
+static const unsigned char IAC = 0xff;
+
+#ifdef Q5250_IACSCANNER_X86
+
+static const char *findInterpretAsCommandSse2(const char *begin, const char *end)
+{
+    const __m128i iac = _mm_set1_epi8((char)IAC);
+
+    while (end - begin >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, iac));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 16;
+    }
+
+    const void *found = std::memchr(begin, IAC, end - begin);
+    return found ? static_cast<const char*>(found) : end;
+}
+
+__attribute__((target("avx2")))
+static const char *findInterpretAsCommandAvx2(const char *begin, const char *end)
+{
+    const __m256i iac = _mm256_set1_epi8((char)IAC);
+
+    while (end - begin >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, iac));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 32;
+    }
+
+    return findInterpretAsCommandSse2(begin, end);
+}
+
+typedef const char *(*ScanFunction)(const char *, const char *);
+
+static ScanFunction selectScanFunction()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? findInterpretAsCommandAvx2
+                                          : findInterpretAsCommandSse2;
+}
+
+const char *findInterpretAsCommand(const char *begin, const char *end)
+{
+    static const ScanFunction scan = selectScanFunction();
+    return scan(begin, end);
+}
+
+#else
+
+const char *findInterpretAsCommand(const char *begin, const char *end)
+{
+    const void *found = std::memchr(begin, IAC, end - begin);
+    return found ? static_cast<const char*>(found) : end;
+}
+
+#endif
+
+} // namespace q5250
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "iouringreactor.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+#include "iouringtelnetconnection.h"
+
+namespace q5250 {
+
+static const unsigned RingEntries = 1024;
+static const unsigned short BufferGroup = 0;
+
+enum class Operation : unsigned char
+{
+    Connect = 1,
+    Receive,
+    Send,
+    Cancel
+};
+
+// user data of a request: connection slot, slot generation and operation
+static quint64 userData(int slot, quint32 generation, Operation operation)
+{
+    return (quint64(slot) << 32) | (quint64(generation & 0xffffff) << 8) | quint64(operation);
+}
+
+static bool kernelSupportsMultishotReceive()
+{
+    // multishot receive has been added in Linux 6.0
+    utsname name;
+    if (uname(&name) != 0) {
+        return false;
+    }
+
+    int major = 0;
+    return sscanf(name.release, "%d", &major) == 1 && major >= 6;
+}
+
+class IoUringReactor::Private
+{
+public:
+    Private() :
+        ringFd(-1),
+        ringMemory(MAP_FAILED), ringMemorySize(0),
+        sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), sqesSize(0),
+        bufferRing(static_cast<io_uring_buf*>(MAP_FAILED)), bufferRingSize(0),
+        bufferCount(0), bufferSize(0),
+        sqTailLocal(0), submittedTail(0)
+    {}
+
+    bool setup(int bufferCount, int bufferSize);
+    void release();
+
+    io_uring_sqe *nextSqe();
+    int enter(unsigned toSubmit, unsigned minComplete, int timeout);
+
+    void addBuffer(int bufferId);
+
+    IoUringTelnetConnection *connection(quint64 userData) const;
+
+    int ringFd;
+    void *ringMemory;
+    size_t ringMemorySize;
+    io_uring_sqe *sqes;
+    size_t sqesSize;
+
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    io_uring_cqe *cqes;
+
+    io_uring_buf *bufferRing;
+    size_t bufferRingSize;
+    std::vector<char> buffers;
+    int bufferCount;
+    int bufferSize;
+    unsigned short bufferRingTail;
+
+    unsigned sqTailLocal;
+    unsigned submittedTail;
+
+    std::vector<IoUringTelnetConnection*> connections;
+    std::vector<quint32> generations;
+    std::vector<int> freeSlots;
+    std::vector<quint64> starvedReceives;
+    std::map<quint64, QByteArray> orphanedSends;
+};
+
+bool IoUringReactor::Private::setup(int bufferCount, int bufferSize)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    // multishot receives post many completions per request
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = RingEntries * 8;
+
+    ringFd = syscall(__NR_io_uring_setup, RingEntries, &params);
+    if (ringFd < 0) {
+        return false;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        return false;
+    }
+
+    ringMemorySize = qMax(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ringMemory = mmap(nullptr, ringMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_SQ_RING);
+    if (ringMemory == MAP_FAILED) {
+        return false;
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                           ringFd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+
+    char *ring = static_cast<char*>(ringMemory);
+    sqHead = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqArray = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+
+    sqTailLocal = submittedTail = *sqTail;
+
+    // register the ring of receive buffers, the kernel picks
+    // a free buffer for every multishot receive completion
+    this->bufferCount = bufferCount;
+    this->bufferSize = bufferSize;
+    buffers.resize(size_t(bufferCount) * bufferSize);
+
+    bufferRingSize = bufferCount * sizeof(io_uring_buf);
+    bufferRing = static_cast<io_uring_buf*>(mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE,
+                                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (bufferRing == MAP_FAILED) {
+        return false;
+    }
+
+    io_uring_buf_reg registration;
+    std::memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = reinterpret_cast<quint64>(bufferRing);
+    registration.ring_entries = bufferCount;
+    registration.bgid = BufferGroup;
+
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0) {
+        return false;
+    }
+
+    bufferRingTail = 0;
+    for (int i = 0; i < bufferCount; ++i) {
+        addBuffer(i);
+    }
+
+    return true;
+}
+
+void IoUringReactor::Private::release()
+{
+    // called again by the destructor after a failed setup
+    if (bufferRing != MAP_FAILED) munmap(bufferRing, bufferRingSize);
+    if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+    if (ringMemory != MAP_FAILED) munmap(ringMemory, ringMemorySize);
+    if (ringFd >= 0) ::close(ringFd);
+
+    bufferRing = static_cast<io_uring_buf*>(MAP_FAILED);
+    bufferRingSize = 0;
+    sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    sqesSize = 0;
+    ringMemory = MAP_FAILED;
+    ringMemorySize = 0;
+    ringFd = -1;
+}
+
+io_uring_sqe *IoUringReactor::Private::nextSqe()
+{
+    // submit the queued requests if the submission queue is full
+    if (sqTailLocal - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        enter(sqTailLocal - submittedTail, 0, 0);
+    }
+
+    const unsigned index = sqTailLocal & sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    sqArray[index] = index;
+    ++sqTailLocal;
+    __atomic_store_n(sqTail, sqTailLocal, __ATOMIC_RELEASE);
+
+    return sqe;
+}
+
+int IoUringReactor::Private::enter(unsigned toSubmit, unsigned minComplete, int timeout)
+{
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    __kernel_timespec ts;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    if (minComplete > 0 && timeout >= 0) {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000LL;
+        arg.ts = reinterpret_cast<quint64>(&ts);
+        arg.sigmask_sz = _NSIG / 8;
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+
+    int result = syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags,
+                         (flags & IORING_ENTER_EXT_ARG) ? static_cast<void*>(&arg) : nullptr,
+                         (flags & IORING_ENTER_EXT_ARG) ? sizeof(arg) : 0);
+    if (result >= 0) {
+        submittedTail += result;
+    }
+
+    return result;
+}
+
+void IoUringReactor::Private::addBuffer(int bufferId)
+{
+    // io_uring_buf_ring::bufs is misplaced when compiled as C++, so the
+    // ring is used as plain array with the tail in the first resv field
+    const unsigned short mask = bufferCount - 1;
+    io_uring_buf &buffer = bufferRing[bufferRingTail & mask];
+
+    buffer.addr = reinterpret_cast<quint64>(buffers.data() + size_t(bufferId) * bufferSize);
+    buffer.len = bufferSize;
+    buffer.bid = bufferId;
+
+    ++bufferRingTail;
+    __atomic_store_n(&bufferRing[0].resv, bufferRingTail, __ATOMIC_RELEASE);
+}
+
+IoUringTelnetConnection *IoUringReactor::Private::connection(quint64 userData) const
+{
+    const size_t slot = userData >> 32;
+    const quint32 generation = (userData >> 8) & 0xffffff;
+
+    if (slot >= connections.size() || (generations[slot] & 0xffffff) != generation) {
+        return nullptr;
+    }
+
+    return connections[slot];
+}
+
+IoUringReactor::IoUringReactor(int bufferCount, int bufferSize) :
+    d(new Private)
+{
+    // the buffer ring needs a power of two number of entries
+    int count = 1;
+    while (count < bufferCount && count < 32768) {
+        count *= 2;
+    }
+
+    if (!kernelSupportsMultishotReceive() || !d->setup(count, bufferSize)) {
+        d->release();
+    }
+}
+
+IoUringReactor::~IoUringReactor()
+{
+    d->release();
+}
+
+bool IoUringReactor::isValid() const
+{
+    return d->ringFd >= 0;
+}
+
+std::unique_ptr<NativeTelnetConnection> IoUringReactor::createConnection()
+{
+    return std::unique_ptr<NativeTelnetConnection>(new IoUringTelnetConnection(*this));
+}
+
+int IoUringReactor::processEvents(int timeout)
+{
+    if (!isValid()) return -1;
+
+    // one system call submits all queued requests and waits for completions
+    int result = d->enter(d->sqTailLocal - d->submittedTail, timeout == 0 ? 0 : 1, timeout);
+    if (result < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+        return -1;
+    }
+
+    int count = 0;
+    unsigned head = *d->cqHead;
+
+    while (head != __atomic_load_n(d->cqTail, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe cqe = d->cqes[head & d->cqMask];
+        __atomic_store_n(d->cqHead, ++head, __ATOMIC_RELEASE);
+        ++count;
+
+        const Operation operation = Operation(cqe.user_data & 0xff);
+        const int bufferId = (cqe.flags & IORING_CQE_F_BUFFER) ? int(cqe.flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+        if (operation == Operation::Send) {
+            d->orphanedSends.erase(cqe.user_data);
+        }
+
+        IoUringTelnetConnection *connection = d->connection(cqe.user_data);
+        if (!connection) {
+            // completion of a closed connection
+            if (bufferId >= 0) {
+                recycleBuffer(bufferId);
+            }
+            continue;
+        }
+
+        switch (operation) {
+        case Operation::Connect:
+            connection->connectCompleted(cqe.res);
+            break;
+
+        case Operation::Receive:
+            if (cqe.res == -ENOBUFS) {
+                // all buffers are in use, receive again once
+                // the connections have read their data
+                d->starvedReceives.push_back(cqe.user_data);
+            } else {
+                connection->receiveCompleted(cqe.res, bufferId, cqe.flags & IORING_CQE_F_MORE);
+            }
+            break;
+
+        case Operation::Send:
+            connection->sendCompleted(cqe.res);
+            break;
+
+        case Operation::Cancel:
+            break;
+        }
+    }
+
+    std::vector<quint64> starved;
+    starved.swap(d->starvedReceives);
+    for (quint64 userData : starved) {
+        IoUringTelnetConnection *connection = d->connection(userData);
+        if (connection && connection->isConnected()) {
+            submitReceive(userData >> 32, connection->socketFd);
+        }
+    }
+
+    return count;
+}
+
+int IoUringReactor::registerConnection(IoUringTelnetConnection *connection)
+{
+    if (!d->freeSlots.empty()) {
+        int slot = d->freeSlots.back();
+        d->freeSlots.pop_back();
+        d->connections[slot] = connection;
+        return slot;
+    }
+
+    d->connections.push_back(connection);
+    d->generations.push_back(0);
+    return d->connections.size() - 1;
+}
+
+void IoUringReactor::unregisterConnection(int slot, const QByteArray &dataInFlight)
+{
+    // the kernel may still read the data of a send request in flight
+    if (!dataInFlight.isEmpty()) {
+        d->orphanedSends[userData(slot, d->generations[slot], Operation::Send)] = dataInFlight;
+    }
+
+    // completions of the old generation are dropped
+    d->connections[slot] = nullptr;
+    ++d->generations[slot];
+    d->freeSlots.push_back(slot);
+}
+
+void IoUringReactor::submitConnect(int slot, int fd, const QByteArray &address)
+{
+    io_uring_sqe *sqe = d->nextSqe();
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<quint64>(address.constData());
+    sqe->off = address.size();
+    sqe->user_data = userData(slot, d->generations[slot], Operation::Connect);
+}
+
+void IoUringReactor::submitReceive(int slot, int fd)
+{
+    io_uring_sqe *sqe = d->nextSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BufferGroup;
+    sqe->user_data = userData(slot, d->generations[slot], Operation::Receive);
+}
+
+void IoUringReactor::submitSend(int slot, int fd, const char *data, int size)
+{
+    io_uring_sqe *sqe = d->nextSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<quint64>(data);
+    sqe->len = size;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = userData(slot, d->generations[slot], Operation::Send);
+}
+
+void IoUringReactor::submitCancel(int fd)
+{
+    io_uring_sqe *sqe = d->nextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = userData(0, 0, Operation::Cancel);
+}
+
+void IoUringReactor::submit()
+{
+    if (d->sqTailLocal != d->submittedTail) {
+        d->enter(d->sqTailLocal - d->submittedTail, 0, 0);
+    }
+}
+
+const char *IoUringReactor::bufferData(int bufferId) const
+{
+    return d->buffers.data() + size_t(bufferId) * d->bufferSize;
+}
+
+void IoUringReactor::recycleBuffer(int bufferId)
+{
+    d->addBuffer(bufferId);
+}
+
+} // namespace q5250
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_IOURINGREACTOR_H
+#define Q5250_IOURINGREACTOR_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+
+#include "telnetreactor.h"
+
+namespace q5250 {
+
+class IoUringTelnetConnection;
+
+/*
+ * Telnet reactor on top of io_uring (Linux 6.0 or later).
+ *
+ * All connections receive with multishot receive requests into a ring of
+ * buffers registered with the kernel, so an idle connection costs no
+ * system call and one io_uring_enter() submits and reaps the requests of
+ * all connections. Use isValid() to check if the kernel supports it.
+ */
+class Q5250SHARED_EXPORT IoUringReactor : public TelnetReactor
+{
+public:
+    explicit IoUringReactor(int bufferCount = 1024, int bufferSize = 4096);
+    ~IoUringReactor();
+
+    bool isValid() const;
+
+    std::unique_ptr<NativeTelnetConnection> createConnection() Q_DECL_OVERRIDE;
+    int processEvents(int timeout) Q_DECL_OVERRIDE;
+
+private:
+    friend class IoUringTelnetConnection;
+
+    int registerConnection(IoUringTelnetConnection *connection);
+    void unregisterConnection(int slot, const QByteArray &dataInFlight);
+
+    void submitConnect(int slot, int fd, const QByteArray &address);
+    void submitReceive(int slot, int fd);
+    void submitSend(int slot, int fd, const char *data, int size);
+    void submitCancel(int fd);
+    void submit();
+
+    const char *bufferData(int bufferId) const;
+    void recycleBuffer(int bufferId);
+
+    class Private;
+    std::unique_ptr<Private> d;
+};
+
+} // namespace q5250
+
+#endif // Q5250_IOURINGREACTOR_H
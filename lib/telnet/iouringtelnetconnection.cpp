@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "iouringtelnetconnection.h"
+
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QString>
+
+#include "iouringreactor.h"
+
+namespace q5250 {
+
+static const int ReadAllChunkSize = 4096;
+
+IoUringTelnetConnection::IoUringTelnetConnection(IoUringReactor &reactor) :
+    reactor(reactor),
+    socketFd(-1),
+    slot(-1),
+    state(State::Unconnected),
+    endOfStream(false),
+    sendOffset(0),
+    sending(false)
+{
+}
+
+IoUringTelnetConnection::~IoUringTelnetConnection()
+{
+    close();
+}
+
+bool IoUringTelnetConnection::isConnected() const
+{
+    return state == State::Connected;
+}
+
+void IoUringTelnetConnection::close()
+{
+    if (socketFd < 0) return;
+
+    // cancel all requests before the descriptor is closed
+    reactor.submitCancel(socketFd);
+    reactor.submit();
+    reactor.unregisterConnection(slot, sending ? dataInFlight : QByteArray());
+    ::close(socketFd);
+
+    for (const Segment &segment : segments) {
+        reactor.recycleBuffer(segment.bufferId);
+    }
+    segments.clear();
+
+    socketFd = -1;
+    slot = -1;
+    state = State::Unconnected;
+    endOfStream = false;
+    pendingData.clear();
+    dataInFlight.clear();
+    sendOffset = 0;
+    sending = false;
+}
+
+void IoUringTelnetConnection::connectToHost(const QString &hostName, quint16 port)
+{
+    close();
+
+    // name resolution blocks, the connect itself does not
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(hostName.toLatin1().constData(), QByteArray::number(port).constData(), &hints, &addresses) != 0) {
+        return;
+    }
+
+    for (addrinfo *info = addresses; info; info = info->ai_next) {
+        // io_uring handles the waiting, so the socket stays blocking
+        int fd = ::socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC, info->ai_protocol);
+        if (fd < 0) continue;
+
+        // telnet records are small and latency bound
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        socketFd = fd;
+        address = QByteArray(reinterpret_cast<const char*>(info->ai_addr), info->ai_addrlen);
+        break;
+    }
+
+    freeaddrinfo(addresses);
+
+    if (socketFd < 0) return;
+
+    state = State::Connecting;
+    slot = reactor.registerConnection(this);
+    reactor.submitConnect(slot, socketFd, address);
+    reactor.submit();
+}
+
+QByteArray IoUringTelnetConnection::readAll()
+{
+    QByteArray data;
+
+    qint64 bytesRead;
+    do {
+        int size = data.size();
+        data.resize(size + ReadAllChunkSize);
+        bytesRead = read(data.data() + size, ReadAllChunkSize);
+        data.resize(size + qMax(bytesRead, qint64(0)));
+    } while (bytesRead == ReadAllChunkSize);
+
+    return data;
+}
+
+qint64 IoUringTelnetConnection::read(char *data, qint64 maxSize)
+{
+    if (state != State::Connected) return -1;
+
+    qint64 bytesRead = 0;
+
+    while (bytesRead < maxSize && !segments.empty()) {
+        Segment &segment = segments.front();
+        const int size = qMin(qint64(segment.size), maxSize - bytesRead);
+
+        std::memcpy(data + bytesRead, reactor.bufferData(segment.bufferId) + segment.offset, size);
+        bytesRead += size;
+        segment.offset += size;
+        segment.size -= size;
+
+        if (segment.size == 0) {
+            reactor.recycleBuffer(segment.bufferId);
+            segments.pop_front();
+        }
+    }
+
+    // closed by the server or connection error
+    if (bytesRead == 0 && endOfStream) {
+        close();
+        return -1;
+    }
+
+    return bytesRead;
+}
+
+void IoUringTelnetConnection::write(const QByteArray &data)
+{
+    if (socketFd < 0) return;
+
+    pendingData.append(data);
+
+    if (state == State::Connected && !sending) {
+        sendPendingData();
+    }
+}
+
+void IoUringTelnetConnection::connectCompleted(int result)
+{
+    if (result < 0) {
+        close();
+        return;
+    }
+
+    state = State::Connected;
+    reactor.submitReceive(slot, socketFd);
+
+    if (!pendingData.isEmpty()) {
+        sendPendingData();
+    }
+
+    connected();
+}
+
+void IoUringTelnetConnection::receiveCompleted(int result, int bufferId, bool more)
+{
+    if (result > 0 && bufferId >= 0) {
+        segments.push_back(Segment{bufferId, 0, result});
+    } else {
+        if (bufferId >= 0) {
+            reactor.recycleBuffer(bufferId);
+        }
+        endOfStream = true;
+    }
+
+    if (!more && !endOfStream) {
+        // the kernel stopped the multishot receive, e.g. after an overflow
+        reactor.submitReceive(slot, socketFd);
+    }
+
+    readyRead();
+}
+
+void IoUringTelnetConnection::sendCompleted(int result)
+{
+    if (result < 0 && result != -EINTR && result != -EAGAIN) {
+        close();
+        return;
+    }
+
+    sendOffset += qMax(result, 0);
+
+    if (sendOffset < dataInFlight.size()) {
+        reactor.submitSend(slot, socketFd, dataInFlight.constData() + sendOffset, dataInFlight.size() - sendOffset);
+        return;
+    }
+
+    sending = false;
+    dataInFlight.clear();
+    sendOffset = 0;
+
+    if (!pendingData.isEmpty()) {
+        sendPendingData();
+    }
+}
+
+void IoUringTelnetConnection::sendPendingData()
+{
+    // the kernel reads the data in flight asynchronously, so new data
+    // is collected in a separate buffer until the request completes
+    dataInFlight.swap(pendingData);
+    sendOffset = 0;
+    sending = true;
+
+    reactor.submitSend(slot, socketFd, dataInFlight.constData(), dataInFlight.size());
+}
+
+} // namespace q5250
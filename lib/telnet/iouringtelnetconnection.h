@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_IOURINGTELNETCONNECTION_H
+#define Q5250_IOURINGTELNETCONNECTION_H
+
+#include "q5250_global.h"
+
+#include <deque>
+#include <QByteArray>
+
+#include "nativetelnetconnection.h"
+
+namespace q5250 {
+
+class IoUringReactor;
+
+/*
+ * Telnet connection driven by an IoUringReactor.
+ *
+ * Received data stays in the registered buffers of the reactor until
+ * read() copies it into the caller's buffer. Outgoing data is collected
+ * while a send request is in flight and sent with the next request.
+ */
+class Q5250SHARED_EXPORT IoUringTelnetConnection : public NativeTelnetConnection
+{
+public:
+    explicit IoUringTelnetConnection(IoUringReactor &reactor);
+    ~IoUringTelnetConnection();
+
+    bool isConnected() const Q_DECL_OVERRIDE;
+    void close() Q_DECL_OVERRIDE;
+
+    void connectToHost(const QString &hostName, quint16 port) Q_DECL_OVERRIDE;
+
+    QByteArray readAll() Q_DECL_OVERRIDE;
+    qint64 read(char *data, qint64 maxSize) Q_DECL_OVERRIDE;
+    void write(const QByteArray &data) Q_DECL_OVERRIDE;
+
+private:
+    friend class IoUringReactor;
+
+    enum class State { Unconnected, Connecting, Connected };
+
+    struct Segment
+    {
+        int bufferId;
+        int offset;
+        int size;
+    };
+
+    void connectCompleted(int result);
+    void receiveCompleted(int result, int bufferId, bool more);
+    void sendCompleted(int result);
+    void sendPendingData();
+
+    IoUringReactor &reactor;
+    int socketFd;
+    int slot;
+    State state;
+    bool endOfStream;
+    QByteArray address;
+    std::deque<Segment> segments;
+    QByteArray pendingData;
+    QByteArray dataInFlight;
+    int sendOffset;
+    bool sending;
+};
+
+} // namespace q5250
+
+#endif // Q5250_IOURINGTELNETCONNECTION_H
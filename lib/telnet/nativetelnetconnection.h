@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_NATIVETELNETCONNECTION_H
+#define Q5250_NATIVETELNETCONNECTION_H
+
+#include "q5250_global.h"
+
+#include <functional>
+
+#include "telnetconnection.h"
+
+namespace q5250 {
+
+/*
+ * Base class of the telnet connections driven by a TelnetReactor
+ * instead of the Qt event loop.
+ *
+ * These are no QObjects, so connected() and readyRead() call the
+ * handlers set with setConnectedHandler() and setReadyReadHandler().
+ * The readyRead handler must read until read() returns less than
+ * requested.
+ */
+class Q5250SHARED_EXPORT NativeTelnetConnection : public TelnetConnection
+{
+public:
+    virtual ~NativeTelnetConnection() {}
+
+    void setConnectedHandler(std::function<void ()> handler);
+    void setReadyReadHandler(std::function<void ()> handler);
+
+    virtual bool isConnected() const = 0;
+    virtual void close() = 0;
+
+    void connected() Q_DECL_OVERRIDE;
+    void readyRead() Q_DECL_OVERRIDE;
+
+private:
+    std::function<void ()> connectedHandler;
+    std::function<void ()> readyReadHandler;
+};
+
+} // namespace q5250
+
+#endif // Q5250_NATIVETELNETCONNECTION_H
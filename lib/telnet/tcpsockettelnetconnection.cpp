@@ -53,6 +53,11 @@ QByteArray TcpSocketTelnetConnection::readAll()
     return socket->readAll();
 }
 
+qint64 TcpSocketTelnetConnection::read(char *data, qint64 maxSize)
+{
+    return socket->read(data, maxSize);
+}
+
 void TcpSocketTelnetConnection::write(const QByteArray &data)
 {
     socket->write(data);
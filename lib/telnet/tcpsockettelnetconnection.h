@@ -45,6 +45,7 @@ public:
     void connectToHost(const QString &hostName, quint16 port) Q_DECL_OVERRIDE;
 
     QByteArray readAll() Q_DECL_OVERRIDE;
+    qint64 read(char *data, qint64 maxSize) Q_DECL_OVERRIDE;
     void write(const QByteArray &data) Q_DECL_OVERRIDE;
 
 signals:
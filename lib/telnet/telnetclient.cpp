@@ -29,16 +29,15 @@
 
 namespace q5250 {
 
+static const int ReadChunkSize = 4096;
+
 TelnetClient::TelnetClient(TelnetConnection *conn) :
     connection(conn),
-    terminalType("UNKNOWN")
+    parser(*this),
+    receiving(false),
+    terminalType("UNKNOWN"),
+    offerOptionsOnConnect(false)
 {
-    connect(&parser, &TelnetParser::dataReceived,
-            this, &TelnetClient::dataReceived);
-    connect(&parser, &TelnetParser::optionNegotiationReceived,
-            this, &TelnetClient::optionNegotiationReceived);
-    connect(&parser, &TelnetParser::subnegotiationReceived,
-            this, &TelnetClient::subnegotiationReceived);
 }
 
 void TelnetClient::setTerminalType(const QString &type)
@@ -46,42 +45,129 @@ void TelnetClient::setTerminalType(const QString &type)
     terminalType = type;
 }
 
+void TelnetClient::setEnvironment(const TelnetEnvironment &environment)
+{
+    this->environment = environment;
+}
+
+void TelnetClient::setOfferOptionsOnConnect(bool offer)
+{
+    offerOptionsOnConnect = offer;
+}
+
+bool TelnetClient::isLocalOptionEnabled(TelnetOption option) const
+{
+    return localOptions[(unsigned char)option].state == OptionState::Yes;
+}
+
+bool TelnetClient::isRemoteOptionEnabled(TelnetOption option) const
+{
+    return remoteOptions[(unsigned char)option].state == OptionState::Yes;
+}
+
+void TelnetClient::connected()
+{
+    if (!offerOptionsOnConnect) return;
+
+    // offer the options a 5250 session needs up front to save
+    // the round trips of waiting for the host to ask for them
+    static const TelnetOption willOptions[] = {
+        TelnetOption::TERMINAL_TYPE, TelnetOption::END_OF_RECORD, TelnetOption::TRANSMIT_BINARY
+    };
+    static const TelnetOption doOptions[] = {
+        TelnetOption::END_OF_RECORD, TelnetOption::TRANSMIT_BINARY
+    };
+
+    for (TelnetOption option : willOptions) {
+        requestOption(localOptions[(unsigned char)option], option, true, TelnetCommand::WILL, TelnetCommand::WONT);
+    }
+    for (TelnetOption option : doOptions) {
+        requestOption(remoteOptions[(unsigned char)option], option, true, TelnetCommand::DO, TelnetCommand::DONT);
+    }
+
+    flush();
+}
+
 void TelnetClient::readyRead()
 {
-    QByteArray buffer = connection->readAll();
-    parser.parse(buffer);
+    // read directly into the receive buffer, the parser removes
+    // the telnet commands in place and emits the records as views
+    // into this buffer
+    qint64 bytesRead;
+    do {
+        char *data = receiveBuffer.reserve(ReadChunkSize);
+        bytesRead = connection->read(data, ReadChunkSize);
+        if (bytesRead > 0) {
+            receiveBuffer.commit(bytesRead);
+        }
+    } while (bytesRead == ReadChunkSize);
+
+    // collect all replies to the received chunk and send them
+    // with a single write
+    receiving = true;
+    parser.parse(receiveBuffer);
+    receiving = false;
+
+    flush();
 }
 
 void TelnetClient::sendData(const QByteArray &data)
 {
+    sendDataSegments({ data });
+}
+
+void TelnetClient::sendDataSegments(std::initializer_list<QByteArray> segments)
+{
+    // the segments form one record, e.g. header, body and trailer
+    // of a data stream, and are escaped straight into the send buffer
+    for (const QByteArray &segment : segments) {
+        sendBuffer.appendEscaped(segment);
+    }
+
     // append end-of-record command sequence
-    QByteArray reply(data);
-    reply.append((char)TelnetCommand::IAC);
-    reply.append((char)TelnetCommand::EOR);
+    static const char EndOfRecord[] = { (char)TelnetCommand::IAC, (char)TelnetCommand::EOR };
+    sendBuffer.append(EndOfRecord, sizeof(EndOfRecord));
 
-    connection->write(reply);
+    if (!receiving) {
+        flush();
+    }
 }
 
-void TelnetClient::optionNegotiationReceived(const OptionNegotiation &optionNegotiation)
+void TelnetClient::optionNegotiationReceived(TelnetCommand command, TelnetOption option)
 {
-    bool supported = isOptionSupported(optionNegotiation.option);
-    sendCommand(replyFor(optionNegotiation.command, supported), optionNegotiation.option);
+    OptionSide &local = localOptions[(unsigned char)option];
+    OptionSide &remote = remoteOptions[(unsigned char)option];
+
+    switch (command) {
+    case TelnetCommand::WILL:
+        enableReceived(remote, option, TelnetCommand::DO, TelnetCommand::DONT);
+        break;
+
+    case TelnetCommand::WONT:
+        disableReceived(remote, option, TelnetCommand::DO, TelnetCommand::DONT);
+        break;
+
+    case TelnetCommand::DO:
+        enableReceived(local, option, TelnetCommand::WILL, TelnetCommand::WONT);
+        break;
+
+    case TelnetCommand::DONT:
+        disableReceived(local, option, TelnetCommand::WILL, TelnetCommand::WONT);
+        break;
+
+    default:
+        break;
+    }
 }
 
-void TelnetClient::subnegotiationReceived(const Subnegotiation &subnegotiation)
+void TelnetClient::subnegotiationReceived(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters)
 {
-    if (subnegotiation.option == TelnetOption::TERMINAL_TYPE && subnegotiation.command == SubnegotiationCommand::SEND) {
-        QByteArray reply;
-
-        reply += (char)TelnetCommand::IAC;
-        reply += (char)TelnetCommand::SB;
-        reply += (char)TelnetOption::TERMINAL_TYPE;
-        reply += (char)SubnegotiationCommand::IS;
-        reply += terminalType;
-        reply += (char)TelnetCommand::IAC;
-        reply += (char)TelnetCommand::SE;
+    if (command != SubnegotiationCommand::SEND) return;
 
-        sendCommand(reply);
+    if (option == TelnetOption::TERMINAL_TYPE) {
+        sendSubnegotiation(option, SubnegotiationCommand::IS, terminalType.toLatin1());
+    } else if (option == TelnetOption::NEW_ENVIRON) {
+        sendSubnegotiation(option, SubnegotiationCommand::IS, environment.reply(parameters));
     }
 }
 
@@ -97,7 +183,25 @@ void TelnetClient::sendCommand(TelnetCommand command, TelnetOption option)
 
 void TelnetClient::sendCommand(const QByteArray &command)
 {
-    connection->write(command);
+    sendBuffer.append(command);
+}
+
+void TelnetClient::sendSubnegotiation(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters)
+{
+    const char begin[] = { (char)TelnetCommand::IAC, (char)TelnetCommand::SB, (char)option, (char)command };
+    const char end[] = { (char)TelnetCommand::IAC, (char)TelnetCommand::SE };
+
+    sendBuffer.append(begin, sizeof(begin));
+    sendBuffer.appendEscaped(parameters);
+    sendBuffer.append(end, sizeof(end));
+}
+
+void TelnetClient::flush()
+{
+    if (sendBuffer.isEmpty()) return;
+
+    connection->write(sendBuffer.data());
+    sendBuffer.clear();
 }
 
 bool TelnetClient::isOptionSupported(TelnetOption option)
@@ -109,14 +213,86 @@ bool TelnetClient::isOptionSupported(TelnetOption option)
            option == TelnetOption::TRANSMIT_BINARY;
 }
 
-TelnetCommand TelnetClient::replyFor(TelnetCommand command, bool supported)
+void TelnetClient::requestOption(OptionSide &side, TelnetOption option, bool enable, TelnetCommand accept, TelnetCommand refuse)
 {
-    switch (command) {
-    case TelnetCommand::DO:
-        return supported ? TelnetCommand::WILL : TelnetCommand::WONT;
+    const OptionState wanted = enable ? OptionState::Yes : OptionState::No;
+    const OptionState pending = enable ? OptionState::WantYes : OptionState::WantNo;
 
-    case TelnetCommand::WILL:
-        return supported ? TelnetCommand::DO : TelnetCommand::DONT;
+    if (side.state == wanted) return;
+
+    if (side.state == pending) {
+        // a queued opposite request is cancelled
+        side.queued = false;
+    } else if (side.state == OptionState::Yes || side.state == OptionState::No) {
+        side.state = pending;
+        sendCommand(enable ? accept : refuse, option);
+    } else {
+        // wait for the pending answer before asking again
+        side.queued = true;
+    }
+}
+
+void TelnetClient::enableReceived(OptionSide &side, TelnetOption option, TelnetCommand accept, TelnetCommand refuse)
+{
+    switch (side.state) {
+    case OptionState::No:
+        if (isOptionSupported(option)) {
+            side.state = OptionState::Yes;
+            sendCommand(accept, option);
+        } else {
+            sendCommand(refuse, option);
+        }
+        break;
+
+    case OptionState::Yes:
+        // already enabled, never acknowledge again
+        break;
+
+    case OptionState::WantNo:
+        // without a queued request the peer answered our
+        // disable request with an enable which is a protocol error
+        side.state = side.queued ? OptionState::Yes : OptionState::No;
+        side.queued = false;
+        break;
+
+    case OptionState::WantYes:
+        if (side.queued) {
+            side.state = OptionState::WantNo;
+            side.queued = false;
+            sendCommand(refuse, option);
+        } else {
+            side.state = OptionState::Yes;
+        }
+        break;
+    }
+}
+
+void TelnetClient::disableReceived(OptionSide &side, TelnetOption option, TelnetCommand accept, TelnetCommand refuse)
+{
+    switch (side.state) {
+    case OptionState::No:
+        // already disabled, never acknowledge again
+        break;
+
+    case OptionState::Yes:
+        side.state = OptionState::No;
+        sendCommand(refuse, option);
+        break;
+
+    case OptionState::WantNo:
+        if (side.queued) {
+            side.state = OptionState::WantYes;
+            side.queued = false;
+            sendCommand(accept, option);
+        } else {
+            side.state = OptionState::No;
+        }
+        break;
+
+    case OptionState::WantYes:
+        side.state = OptionState::No;
+        side.queued = false;
+        break;
     }
 }
 
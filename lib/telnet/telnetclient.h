@@ -28,10 +28,15 @@
 
 #include "q5250_global.h"
 #include <QObject>
+#include <initializer_list>
 
+#include "basictelnetparser.h"
+#include "subnegotiationcommand.h"
 #include "telnetcommand.h"
+#include "telnetenvironment.h"
 #include "telnetoption.h"
-#include "telnetparser.h"
+#include "telnetreceivebuffer.h"
+#include "telnetsendbuffer.h"
 
 namespace q5250 {
 
@@ -45,26 +50,60 @@ public:
     explicit TelnetClient(TelnetConnection *conn);
 
     void setTerminalType(const QString &type);
+    void setEnvironment(const TelnetEnvironment &environment);
+    void setOfferOptionsOnConnect(bool offer);
 
+    bool isLocalOptionEnabled(TelnetOption option) const;
+    bool isRemoteOptionEnabled(TelnetOption option) const;
+
+    void connected();
     void readyRead();
     void sendData(const QByteArray &data);
+    void sendDataSegments(std::initializer_list<QByteArray> segments);
 
 signals:
+    // data refers to the receive buffer of the client and is only
+    // valid until the next readyRead(). Receivers need to copy it
+    // if they keep the record.
     void dataReceived(const QByteArray &data);
 
-private slots:
-    void optionNegotiationReceived(const q5250::OptionNegotiation &optionNegotiation);
-    void subnegotiationReceived(const q5250::Subnegotiation &subnegotiation);
-
 private:
+    friend class BasicTelnetParser<TelnetClient>;
+    void optionNegotiationReceived(TelnetCommand command, TelnetOption option);
+    void subnegotiationReceived(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters);
+
+    // option negotiation state of one side as described
+    // in the Q method of RFC 1143
+    enum class OptionState : unsigned char { No, Yes, WantNo, WantYes };
+
+    struct OptionSide
+    {
+        OptionSide() : state(OptionState::No), queued(false) {}
+
+        OptionState state;
+        bool queued;
+    };
+
+    void requestOption(OptionSide &side, TelnetOption option, bool enable, TelnetCommand accept, TelnetCommand refuse);
+    void enableReceived(OptionSide &side, TelnetOption option, TelnetCommand accept, TelnetCommand refuse);
+    void disableReceived(OptionSide &side, TelnetOption option, TelnetCommand accept, TelnetCommand refuse);
+
     void sendCommand(TelnetCommand command, TelnetOption option);
     void sendCommand(const QByteArray &command);
+    void sendSubnegotiation(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters);
+    void flush();
     bool isOptionSupported(TelnetOption option);
-    TelnetCommand replyFor(TelnetCommand command, bool supported);
 
     TelnetConnection *connection;
-    TelnetParser parser;
+    TelnetReceiveBuffer receiveBuffer;
+    BasicTelnetParser<TelnetClient> parser;
+    TelnetSendBuffer sendBuffer;
+    bool receiving;
     QString terminalType;
+    TelnetEnvironment environment;
+    bool offerOptionsOnConnect;
+    OptionSide localOptions[256];
+    OptionSide remoteOptions[256];
 };
 
 } // namespace q5250
@@ -29,6 +29,8 @@
 #include "q5250_global.h"
 
 #include <QByteArray>
+#include <QObject>
+#include <QString>
 
 namespace q5250 {
 
@@ -38,6 +40,7 @@ public:
     virtual void connectToHost(const QString &hostName, quint16 port) = 0;
 
     virtual QByteArray readAll() = 0;
+    virtual qint64 read(char *data, qint64 maxSize) = 0;
     virtual void write(const QByteArray &data) = 0;
 
 signals:
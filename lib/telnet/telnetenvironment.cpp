@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "telnetenvironment.h"
+
+#include <QCryptographicHash>
+#include <QList>
+#include <random>
+
+#include "newenvironcode.h"
+
+namespace q5250 {
+
+static const int SeedSize = 8;
+
+namespace {
+
+struct RequestedVariable
+{
+    NewEnvironCode type;
+    QByteArray name;
+    QByteArray data;
+};
+
+}
+
+static QList<RequestedVariable> parseRequest(const QByteArray &request)
+{
+    // SEND [ type [ name ] ]...
+    QList<RequestedVariable> variables;
+    bool escaped = false;
+
+    for (int i = 0; i < request.size(); ++i) {
+        const NewEnvironCode code = (NewEnvironCode)request.at(i);
+
+        if (!escaped && (code == NewEnvironCode::VAR || code == NewEnvironCode::USERVAR)) {
+            variables.append(RequestedVariable{code, QByteArray(), QByteArray()});
+        } else if (!escaped && code == NewEnvironCode::ESC) {
+            escaped = true;
+        } else if (!variables.isEmpty()) {
+            variables.last().name.append(request.at(i));
+            escaped = false;
+        }
+    }
+
+    // the server seed directly follows the IBMRSEED name
+    for (RequestedVariable &variable : variables) {
+        if (variable.name.startsWith("IBMRSEED")) {
+            variable.data = variable.name.mid(8);
+            variable.name = "IBMRSEED";
+        }
+    }
+
+    return variables;
+}
+
+static bool isRequested(const QList<RequestedVariable> &variables, NewEnvironCode type, const QByteArray &name)
+{
+    // an empty request or a type without names asks for all variables
+    if (variables.isEmpty()) {
+        return true;
+    }
+
+    for (const RequestedVariable &variable : variables) {
+        if (variable.type == type && (variable.name.isEmpty() || variable.name == name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void appendVariable(QByteArray &reply, NewEnvironCode type, const QByteArray &name, const QByteArray &value)
+{
+    reply.append((char)type);
+    reply.append(name);
+    reply.append((char)NewEnvironCode::VALUE);
+
+    for (int i = 0; i < value.size(); ++i) {
+        if ((unsigned char)value.at(i) <= (unsigned char)NewEnvironCode::USERVAR) {
+            reply.append((char)NewEnvironCode::ESC);
+        }
+        reply.append(value.at(i));
+    }
+}
+
+static QByteArray randomSeed()
+{
+    std::random_device random;
+
+    QByteArray seed;
+    for (int i = 0; i < SeedSize; ++i) {
+        seed.append((char)(random() & 0xff));
+    }
+
+    return seed;
+}
+
+static QByteArray toUtf16BigEndian(const QString &text)
+{
+    QByteArray data;
+    for (int i = 0; i < text.size(); ++i) {
+        const ushort c = text.at(i).unicode();
+        data.append((char)(c >> 8));
+        data.append((char)(c & 0xff));
+    }
+    return data;
+}
+
+static bool isAscii(const QString &text)
+{
+    for (int i = 0; i < text.size(); ++i) {
+        if (text.at(i).unicode() > 0x7f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TelnetEnvironment::TelnetEnvironment() :
+    allowPlainPassword(false)
+{
+}
+
+void TelnetEnvironment::setDeviceName(const QString &name)
+{
+    deviceName = name.toLatin1();
+}
+
+void TelnetEnvironment::setKeyboardType(const QString &type)
+{
+    keyboardType = type.toLatin1();
+}
+
+void TelnetEnvironment::setCodePage(const QString &codePage)
+{
+    this->codePage = codePage.toLatin1();
+}
+
+void TelnetEnvironment::setCharacterSet(const QString &characterSet)
+{
+    this->characterSet = characterSet.toLatin1();
+}
+
+void TelnetEnvironment::setUser(const QString &user)
+{
+    this->user = user;
+}
+
+void TelnetEnvironment::setPassword(const QString &password)
+{
+    this->password = password;
+}
+
+void TelnetEnvironment::setAllowPlainPassword(bool allow)
+{
+    allowPlainPassword = allow;
+}
+
+QByteArray TelnetEnvironment::reply(const QByteArray &request) const
+{
+    const QList<RequestedVariable> variables = parseRequest(request);
+
+    QByteArray serverSeed;
+    for (const RequestedVariable &variable : variables) {
+        if (variable.type == NewEnvironCode::USERVAR && variable.name == "IBMRSEED") {
+            serverSeed = variable.data;
+        }
+    }
+
+    QByteArray reply;
+
+    if (!user.isEmpty() && isRequested(variables, NewEnvironCode::VAR, "USER")) {
+        appendVariable(reply, NewEnvironCode::VAR, "USER", user.toLatin1());
+    }
+
+    if (!user.isEmpty() && !password.isEmpty() &&
+        (!serverSeed.isEmpty() || isRequested(variables, NewEnvironCode::USERVAR, "IBMSUBSPW"))) {
+        if (serverSeed.size() == SeedSize) {
+            const QByteArray clientSeed = randomSeed();
+            appendVariable(reply, NewEnvironCode::USERVAR, "IBMRSEED", clientSeed);
+            appendVariable(reply, NewEnvironCode::USERVAR, "IBMSUBSPW",
+                           passwordSubstitute(user, password, serverSeed, clientSeed));
+        } else if (allowPlainPassword && isAscii(password)) {
+            // an empty IBMRSEED marks the password as clear text (RFC 4777),
+            // other characters are left to the sign-on screen as there is
+            // no code page agreed on yet
+            appendVariable(reply, NewEnvironCode::USERVAR, "IBMRSEED", QByteArray());
+            appendVariable(reply, NewEnvironCode::USERVAR, "IBMSUBSPW", password.toLatin1());
+        }
+    }
+
+    const struct { const char *name; const QByteArray &value; } userVariables[] = {
+        { "DEVNAME", deviceName },
+        { "KBDTYPE", keyboardType },
+        { "CODEPAGE", codePage },
+        { "CHARSET", characterSet }
+    };
+
+    for (const auto &variable : userVariables) {
+        if (!variable.value.isEmpty() && isRequested(variables, NewEnvironCode::USERVAR, variable.name)) {
+            appendVariable(reply, NewEnvironCode::USERVAR, variable.name, variable.value);
+        }
+    }
+
+    return reply;
+}
+
+QByteArray passwordSubstitute(const QString &user, const QString &password,
+                              const QByteArray &serverSeed, const QByteArray &clientSeed)
+{
+    static const char SequenceNumber[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+    // the user id is upper case and padded with blanks to 10 characters
+    const QByteArray userId = toUtf16BigEndian(user.toUpper().leftJustified(10, ' ', true));
+    const QByteArray token = QCryptographicHash::hash(userId + toUtf16BigEndian(password),
+                                                      QCryptographicHash::Sha1);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(token);
+    hash.addData(serverSeed);
+    hash.addData(clientSeed);
+    hash.addData(userId);
+    hash.addData(SequenceNumber, sizeof(SequenceNumber));
+
+    return hash.result();
+}
+
+} // namespace q5250
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_TELNETENVIRONMENT_H
+#define Q5250_TELNETENVIRONMENT_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace q5250 {
+
+// Environment variables sent to the host via the NEW-ENVIRON
+// option (RFC1572, RFC4777). With a user and password set the host
+// signs on automatically and skips the sign-on screen.
+class Q5250SHARED_EXPORT TelnetEnvironment
+{
+public:
+    TelnetEnvironment();
+
+    void setDeviceName(const QString &name);
+    void setKeyboardType(const QString &type);
+    void setCodePage(const QString &codePage);
+    void setCharacterSet(const QString &characterSet);
+    void setUser(const QString &user);
+    void setPassword(const QString &password);
+
+    // Without a server seed the password can only be sent in clear text.
+    // That is off by default: over unencrypted telnet anyone who leaves
+    // out the seed would read the password.
+    void setAllowPlainPassword(bool allow);
+
+    // Returns the variables of the IS reply to the passed parameters
+    // of a SEND request, without the telnet command bytes.
+    QByteArray reply(const QByteArray &request) const;
+
+private:
+    QByteArray deviceName;
+    QByteArray keyboardType;
+    QByteArray codePage;
+    QByteArray characterSet;
+    QString user;
+    QString password;
+    bool allowPlainPassword;
+};
+
+// Returns the SHA-1 password substitute (password level 2 and 3)
+// for the server and client seed exchanged via IBMRSEED.
+Q5250SHARED_EXPORT QByteArray passwordSubstitute(const QString &user, const QString &password,
+                                                 const QByteArray &serverSeed, const QByteArray &clientSeed);
+
+} // namespace q5250
+
+#endif // Q5250_TELNETENVIRONMENT_H
@@ -25,148 +25,40 @@
  */
 #include "telnetparser.h"
 
-namespace q5250 {
+#include "basictelnetparser.h"
+#include "telnetreceivebuffer.h"
 
-static const QByteArray EndOfRecord = "\xff\xef";
+namespace q5250 {
 
 class TelnetParser::Private
 {
 public:
     TelnetParser *q;
+    BasicTelnetParser<Private> parser;
+    TelnetReceiveBuffer receiveBuffer;
 
-    Private(TelnetParser *parent) : q(parent) {}
+    Private(TelnetParser *parent) : q(parent), parser(*this) {}
 
-    int parseCommand(const QByteArray &data);
-    QByteArray replaceEscapedIACBytes(const QByteArray &data);
-    QList<QByteArray> splitAtEndOfRecordCommand(const QByteArray &data);
-    QByteArray subnegotiationParameters(const QByteArray &data);
-    bool isCommand(const QByteArray &data);
-    bool isOptionNegotiation(const QByteArray &data);
-    bool isSubnegotiation(const QByteArray &data);
-    bool isInterpretAsCommand(unsigned char byte);
-    bool isOptionCommand(unsigned char byte);
-    bool isSubnegotiationBeginCommand(unsigned char byte);
-    bool isSubnegotiationEndCommand(unsigned char byte);
+    void dataReceived(const QByteArray &data);
+    void optionNegotiationReceived(TelnetCommand command, TelnetOption option);
+    void subnegotiationReceived(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters);
 };
 
-int TelnetParser::Private::parseCommand(const QByteArray &data)
+void TelnetParser::Private::dataReceived(const QByteArray &data)
 {
-    if (isSubnegotiation(data)) {
-        QByteArray parameters = subnegotiationParameters(data.mid(4));
-        Subnegotiation subnegotiation {
-            (TelnetOption)data.at(2),
-            (SubnegotiationCommand)data.at(3),
-            parameters
-        };
-        emit q->subnegotiationReceived(subnegotiation);
-        return 6 + parameters.size();
-    }
-
-    if (isOptionNegotiation(data)) {
-        OptionNegotiation optionNegotiation {
-            (TelnetCommand)data.at(1),
-            (TelnetOption)data.at(2)
-        };
-        emit q->optionNegotiationReceived(optionNegotiation);
-        return 3;
-    }
-
-    return 2;
+    emit q->dataReceived(data);
 }
 
-QByteArray TelnetParser::Private::replaceEscapedIACBytes(const QByteArray &data)
+void TelnetParser::Private::optionNegotiationReceived(TelnetCommand command, TelnetOption option)
 {
-    QByteArray result(data);
-    result.replace("\xff\xff", "\xff");
-    return result;
+    OptionNegotiation optionNegotiation { command, option };
+    emit q->optionNegotiationReceived(optionNegotiation);
 }
 
-QList<QByteArray> TelnetParser::Private::splitAtEndOfRecordCommand(const QByteArray &data)
+void TelnetParser::Private::subnegotiationReceived(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters)
 {
-    QList<QByteArray> result;
-
-    int from = 0;
-    int to   = data.indexOf(EndOfRecord, from);
-
-    // no end of record at all?
-    if (to < 0) {
-        result.append(data);
-    }
-
-    while (to >= 0) {
-        int length = to - from;
-        result.append(data.mid(from, length));
-
-        from = to + EndOfRecord.length();
-        to   = data.indexOf(EndOfRecord, from);
-    }
-
-    return result;
-}
-
-QByteArray TelnetParser::Private::subnegotiationParameters(const QByteArray &data)
-{
-    QByteArray parameters;
-
-    for (int i = 0; i < data.size(); ++i) {
-        if (isInterpretAsCommand(data[i]) && isSubnegotiationEndCommand(data[i+1])) {
-            parameters = data.mid(0, i);
-            break;
-        }
-    }
-
-    return parameters;
-}
-
-bool TelnetParser::Private::isCommand(const QByteArray &data)
-{
-    // All TELNET commands consist of at least a two byte sequence:  the
-    // "Interpret as Command" (IAC) escape character followed by the code
-    // for the command.
-    return data.size() >= 2 &&
-           isInterpretAsCommand(data.at(0)) &&
-           !isInterpretAsCommand(data.at(1));
-}
-
-bool TelnetParser::Private::isOptionNegotiation(const QByteArray &data)
-{
-    // The commands dealing with option negotiation are
-    // three byte sequences, the third byte being the code for the option
-    // referenced.
-    return data.size() >= 3 &&
-           isInterpretAsCommand(data.at(0)) &&
-           isOptionCommand(data.at(1));
-}
-
-bool TelnetParser::Private::isSubnegotiation(const QByteArray &data)
-{
-    return data.size() >= 6 &&
-           isInterpretAsCommand(data.at(0)) &&
-           isSubnegotiationBeginCommand(data.at(1));
-}
-
-bool TelnetParser::Private::isInterpretAsCommand(unsigned char byte)
-{
-    return (TelnetCommand)byte == TelnetCommand::IAC;
-}
-
-bool TelnetParser::Private::isOptionCommand(unsigned char byte)
-{
-    TelnetCommand command = (TelnetCommand)byte;
-    return command == TelnetCommand::WILL ||
-           command == TelnetCommand::WONT ||
-           command == TelnetCommand::DO   ||
-           command == TelnetCommand::DONT;
-}
-
-bool TelnetParser::Private::isSubnegotiationBeginCommand(unsigned char byte)
-{
-    return (TelnetCommand)byte == TelnetCommand::SB;
-}
-
-bool TelnetParser::Private::isSubnegotiationEndCommand(unsigned char byte)
-{
-    return (TelnetCommand)byte == TelnetCommand::SE;
+    Subnegotiation subnegotiation { option, command, parameters };
+    emit q->subnegotiationReceived(subnegotiation);
 }
 
 
@@ -182,19 +74,13 @@ TelnetParser::~TelnetParser()
 
 void TelnetParser::parse(const QByteArray &data)
 {
-    if (data.isEmpty()) {
-        return;
-    }
+    d->receiveBuffer.append(data.constData(), data.size());
+    parse(d->receiveBuffer);
+}
 
-    if (d->isCommand(data)) {
-        int commandLength = d->parseCommand(data);
-        parse(data.mid(commandLength));
-    } else {
-        QList<QByteArray> dataRecords = d->splitAtEndOfRecordCommand(d->replaceEscapedIACBytes(data));
-        foreach(const QByteArray data, dataRecords) {
-            emit dataReceived(data);
-        }
-    }
+void TelnetParser::parse(TelnetReceiveBuffer &buffer)
+{
+    d->parser.parse(buffer);
 }
 
 } // namespace q5250
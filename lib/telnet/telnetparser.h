@@ -38,6 +38,8 @@
 
 namespace q5250 {
 
+class TelnetReceiveBuffer;
+
 struct Q5250SHARED_EXPORT OptionNegotiation
 {
     TelnetCommand command;
@@ -62,6 +64,8 @@ struct Q5250SHARED_EXPORT Subnegotiation
     }
 };
 
+// QObject adapter around BasicTelnetParser that reports the
+// parsed records and commands as Qt signals.
 class Q5250SHARED_EXPORT TelnetParser : public QObject
 {
     Q_OBJECT
@@ -71,8 +75,11 @@ public:
     ~TelnetParser();
 
     void parse(const QByteArray &data);
+    void parse(TelnetReceiveBuffer &buffer);
 
 signals:
+    // data refers to the receive buffer and is only valid until more
+    // data is received. Receivers that keep the record need to copy it.
     void dataReceived(const QByteArray &data);
     void optionNegotiationReceived(const q5250::OptionNegotiation &optionNegotiation);
     void subnegotiationReceived(const q5250::Subnegotiation &subnegotiation);
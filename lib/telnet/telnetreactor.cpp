@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "telnetreactor.h"
+
+#include "epollreactor.h"
+#ifdef Q5250_WITH_IO_URING
+#include "iouringreactor.h"
+#endif
+
+namespace q5250 {
+
+TelnetReactor::TelnetReactor() :
+    running(false)
+{
+}
+
+std::unique_ptr<TelnetReactor> TelnetReactor::create()
+{
+#ifdef Q5250_WITH_IO_URING
+    std::unique_ptr<IoUringReactor> ioUringReactor(new IoUringReactor());
+    if (ioUringReactor->isValid()) {
+        return std::unique_ptr<TelnetReactor>(ioUringReactor.release());
+    }
+#endif
+
+    return std::unique_ptr<TelnetReactor>(new EpollReactor());
+}
+
+void TelnetReactor::run()
+{
+    running = true;
+
+    while (running) {
+        if (processEvents(-1) < 0) {
+            break;
+        }
+    }
+}
+
+void TelnetReactor::stop()
+{
+    running = false;
+}
+
+} // namespace q5250
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_TELNETREACTOR_H
+#define Q5250_TELNETREACTOR_H
+
+#include "q5250_global.h"
+
+#include <memory>
+
+namespace q5250 {
+
+class NativeTelnetConnection;
+
+/*
+ * Single threaded event loop driving any number of native
+ * telnet connections (Linux only).
+ */
+class Q5250SHARED_EXPORT TelnetReactor
+{
+public:
+    TelnetReactor();
+    virtual ~TelnetReactor() {}
+
+    // Returns an io_uring reactor if the library was built with
+    // io_uring support and the kernel provides it, an epoll
+    // reactor otherwise.
+    static std::unique_ptr<TelnetReactor> create();
+
+    virtual std::unique_ptr<NativeTelnetConnection> createConnection() = 0;
+
+    // Waits up to timeout milliseconds (-1 = forever) and dispatches
+    // all ready events. Returns the number of events or -1 on error.
+    virtual int processEvents(int timeout) = 0;
+
+    void run();
+    void stop();
+
+private:
+    TelnetReactor(const TelnetReactor &) = delete;
+    TelnetReactor &operator=(const TelnetReactor &) = delete;
+
+    bool running;
+};
+
+} // namespace q5250
+
+#endif // Q5250_TELNETREACTOR_H
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "telnetreceivebuffer.h"
+
+#include <cstring>
+
+namespace q5250 {
+
+TelnetReceiveBuffer::TelnetReceiveBuffer(int initialCapacity) :
+    buffer(initialCapacity, '\0'),
+    storage(buffer.data()),
+    recordStart(0),
+    writePosition(0),
+    readPosition(0),
+    endPosition(0)
+{
+}
+
+char *TelnetReceiveBuffer::reserve(int size)
+{
+    compact();
+
+    if (endPosition + size > buffer.size()) {
+        buffer.resize(qMax(endPosition + size, buffer.size() * 2));
+        storage = buffer.data();
+    }
+
+    return storage + endPosition;
+}
+
+void TelnetReceiveBuffer::commit(int size)
+{
+    endPosition += size;
+}
+
+void TelnetReceiveBuffer::append(const char *data, int size)
+{
+    std::memcpy(reserve(size), data, size);
+    commit(size);
+}
+
+int TelnetReceiveBuffer::capacity() const
+{
+    return buffer.size();
+}
+
+int TelnetReceiveBuffer::pendingRecordSize() const
+{
+    return writePosition - recordStart;
+}
+
+void TelnetReceiveBuffer::writeRun(int size)
+{
+    // the record data only needs to be moved if telnet commands
+    // or escaped IAC bytes have been removed before
+    if (writePosition != readPosition) {
+        std::memmove(storage + writePosition, storage + readPosition, size);
+    }
+
+    writePosition += size;
+    readPosition += size;
+}
+
+QByteArray TelnetReceiveBuffer::takeRecord()
+{
+    QByteArray record = QByteArray::fromRawData(storage + recordStart, writePosition - recordStart);
+
+    recordStart = writePosition = readPosition;
+
+    return record;
+}
+
+void TelnetReceiveBuffer::compact()
+{
+    // move the incomplete record and the unparsed data to the
+    // front of the buffer, dropping everything already consumed
+    int recordSize = writePosition - recordStart;
+    int unparsedSize = endPosition - readPosition;
+
+    if (recordStart > 0 && recordSize > 0) {
+        std::memmove(storage, storage + recordStart, recordSize);
+    }
+
+    if (readPosition > recordSize && unparsedSize > 0) {
+        std::memmove(storage + recordSize, storage + readPosition, unparsedSize);
+    }
+
+    recordStart = 0;
+    writePosition = recordSize;
+    readPosition = recordSize;
+    endPosition = recordSize + unparsedSize;
+}
+
+} // namespace q5250
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_TELNETRECEIVEBUFFER_H
+#define Q5250_TELNETRECEIVEBUFFER_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+
+namespace q5250 {
+
+/*
+ * Buffer for the raw data received from the telnet connection.
+ *
+ * The connection reads directly into the free space returned by reserve().
+ * The telnet parser then removes the telnet commands and escaped IAC bytes
+ * in place and hands out each complete record as a view into this buffer.
+ * A record view stays valid until the next call to reserve() or append().
+ */
+class Q5250SHARED_EXPORT TelnetReceiveBuffer
+{
+public:
+    explicit TelnetReceiveBuffer(int initialCapacity = 4096);
+
+    char *reserve(int size);
+    void commit(int size);
+    void append(const char *data, int size);
+
+    int capacity() const;
+    int pendingRecordSize() const;
+
+    bool atEnd() const { return readPosition == endPosition; }
+    unsigned char readByte() { return storage[readPosition++]; }
+    void writeByte(unsigned char byte) { storage[writePosition++] = byte; }
+    void writeRun(int size);
+    QByteArray takeRecord();
+
+    const char *readPointer() const { return storage + readPosition; }
+    const char *endPointer() const { return storage + endPosition; }
+
+private:
+    void compact();
+
+    QByteArray buffer;
+    char *storage;
+    int recordStart;
+    int writePosition;
+    int readPosition;
+    int endPosition;
+};
+
+} // namespace q5250
+
+#endif // Q5250_TELNETRECEIVEBUFFER_H
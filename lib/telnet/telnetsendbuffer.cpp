@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "telnetsendbuffer.h"
+
+#include <cstring>
+
+#include "iacscanner.h"
+
+namespace q5250 {
+
+static const char IAC = '\xff';
+
+TelnetSendBuffer::TelnetSendBuffer(int initialCapacity) :
+    buffer(initialCapacity, '\0'),
+    writePosition(0)
+{
+}
+
+void TelnetSendBuffer::append(const char *data, int size)
+{
+    std::memcpy(reserve(size), data, size);
+    writePosition += size;
+}
+
+void TelnetSendBuffer::appendEscaped(const char *data, int size)
+{
+    const char *end = data + size;
+    const char *iac = findInterpretAsCommand(data, end);
+
+    // fast path: nothing to escape
+    if (iac == end) {
+        append(data, size);
+        return;
+    }
+
+    // every byte from the first IAC on could be an IAC
+    char *out = reserve(size + (end - iac));
+    char *const start = out;
+
+    for (;;) {
+        std::memcpy(out, data, iac - data);
+        out += iac - data;
+        if (iac == end) break;
+
+        *out++ = IAC;
+        *out++ = IAC;
+        data = iac + 1;
+        iac = findInterpretAsCommand(data, end);
+    }
+
+    writePosition += out - start;
+}
+
+int TelnetSendBuffer::capacity() const
+{
+    return buffer.size();
+}
+
+QByteArray TelnetSendBuffer::data() const
+{
+    // view, valid until the next append or clear
+    return QByteArray::fromRawData(buffer.constData(), writePosition);
+}
+
+void TelnetSendBuffer::clear()
+{
+    writePosition = 0;
+}
+
+char *TelnetSendBuffer::reserve(int size)
+{
+    if (writePosition + size > buffer.size()) {
+        buffer.resize(qMax(writePosition + size, buffer.size() * 2));
+    }
+
+    return buffer.data() + writePosition;
+}
+
+} // namespace q5250
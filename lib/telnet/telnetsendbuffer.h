@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_TELNETSENDBUFFER_H
+#define Q5250_TELNETSENDBUFFER_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+
+namespace q5250 {
+
+/*
+ * Buffer for the data sent to the telnet connection.
+ *
+ * Commands and records are collected until the buffer is written to the
+ * connection in one go. Record data is escaped on the way in: IAC bytes are
+ * doubled in a single pass, and data without any IAC byte is copied as is.
+ * The capacity is kept across clear() so the buffer is reused for the whole
+ * session.
+ */
+class Q5250SHARED_EXPORT TelnetSendBuffer
+{
+public:
+    explicit TelnetSendBuffer(int initialCapacity = 4096);
+
+    void append(const char *data, int size);
+    void append(const QByteArray &data) { append(data.constData(), data.size()); }
+    void appendEscaped(const char *data, int size);
+    void appendEscaped(const QByteArray &data) { appendEscaped(data.constData(), data.size()); }
+
+    bool isEmpty() const { return writePosition == 0; }
+    int capacity() const;
+
+    QByteArray data() const;
+    void clear();
+
+private:
+    char *reserve(int size);
+
+    QByteArray buffer;
+    int writePosition;
+};
+
+} // namespace q5250
+
+#endif // Q5250_TELNETSENDBUFFER_H
@@ -44,13 +44,20 @@ public:
     virtual void setBufferAddress(unsigned char column, unsigned char row) = 0;
 
     virtual unsigned char characterAt(unsigned char column, unsigned char row) const = 0;
+    // the width cells of a row, valid until the buffer is next modified
+    virtual const unsigned char *rowCells(unsigned char row) const = 0;
     virtual void setCharacter(unsigned char character) = 0;
+    virtual void writeRun(const unsigned char *data, size_t size) = 0;
     virtual void setCharacterAt(unsigned char increment, unsigned char character) = 0;
     virtual void setCharacterAt(unsigned char column, unsigned char row, unsigned char character) = 0;
     virtual void repeatCharacterToAddress(unsigned char column, unsigned char row, unsigned char character) = 0;
 
     virtual void addField(Field *field) = 0;
     virtual QByteArray fieldContent(const Field *field) const = 0;
+
+    // columns written since the last clearDamage(), false for an unchanged row
+    virtual bool damagedColumns(unsigned char row, unsigned char &firstColumn, unsigned char &lastColumn) const = 0;
+    virtual void clearDamage() = 0;
 };
 
 } // namespace q5250
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ebcdiccodec.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "ebcdictables.h"
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define Q5250_EBCDICCODEC_X86
+#include <immintrin.h>
+#endif
+
+namespace q5250 {
+
+static const unsigned char EbcdicQuestionMark = 0x6f;
+static const unsigned char EbcdicBlank = 0x40;
+
+// Shorter runs (e.g. the tail of a row) are faster through the scalar loop.
+static const int MinimumVectorSize = 64;
+
+static const int CodecCount = sizeof(Codecs) / sizeof(Codecs[0]);
+
+namespace {
+
+// The code page table as shown on the display: NUL and the attribute
+// bytes translate like a blank. The vector path looks up the low and the
+// high byte of each character separately.
+struct DisplayTable
+{
+    ushort unicode[256];
+    alignas(64) unsigned char lowBytes[256];
+    alignas(64) unsigned char highBytes[256];
+    bool latin1;
+};
+
+} // namespace
+
+static void buildDisplayTable(const EbcdicCodec &codec, DisplayTable &table)
+{
+    table.latin1 = true;
+
+    for (int i = 0; i < 256; ++i) {
+        const bool hidden = i == 0x00 || (i >= 0x20 && i <= 0x3f);
+        const ushort unicode = codec.toUnicode(hidden ? EbcdicBlank : i).unicode();
+        table.unicode[i] = unicode;
+        table.lowBytes[i] = unicode & 0xff;
+        table.highBytes[i] = unicode >> 8;
+        table.latin1 = table.latin1 && unicode <= 0xff;
+    }
+}
+
+// Built once on first use, one table per supported CCSID.
+static const DisplayTable *displayTables()
+{
+    static DisplayTable tables[CodecCount];
+    static const bool built = []() {
+        for (int i = 0; i < CodecCount; ++i) {
+            buildDisplayTable(Codecs[i], tables[i]);
+        }
+        return true;
+    }();
+    Q_UNUSED(built);
+
+    return tables;
+}
+
+static void cellsToUnicodeScalar(const DisplayTable &table, const unsigned char *cells, int size, ushort *text)
+{
+    for (int i = 0; i < size; ++i) {
+        text[i] = table.unicode[cells[i]];
+    }
+}
+
+typedef void (*ConvertFunction)(const DisplayTable &, const unsigned char *, int, ushort *);
+
+#ifdef Q5250_EBCDICCODEC_X86
+
+// vpermi2b looks up a cell in a 128 entry table, so the low bytes of the
+// 256 entries take two lookups and the top bit of the cell picks one.
+// Code pages without characters above U+00FF skip the high bytes.
+//
+// The pshufb kernels (16 row lookups per vector) were slower than the
+// scalar loop at every size on AVX2 and SSE4.1 and are not used.
+
+template<bool Latin1>
+__attribute__((target("avx512bw,avx512vbmi")))
+static void cellsToUnicodeVbmi(const DisplayTable &table, const unsigned char *cells, int size, ushort *text)
+{
+    const __m512i lowBytes0 = _mm512_load_si512(table.lowBytes);
+    const __m512i lowBytes1 = _mm512_load_si512(table.lowBytes + 64);
+    const __m512i lowBytes2 = _mm512_load_si512(table.lowBytes + 128);
+    const __m512i lowBytes3 = _mm512_load_si512(table.lowBytes + 192);
+    const __m512i highBytes0 = _mm512_load_si512(table.highBytes);
+    const __m512i highBytes1 = _mm512_load_si512(table.highBytes + 64);
+    const __m512i highBytes2 = _mm512_load_si512(table.highBytes + 128);
+    const __m512i highBytes3 = _mm512_load_si512(table.highBytes + 192);
+
+    // the unpacks work per 128 bit lane, these put the lanes back in order
+    const __m512i firstLanes = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+    const __m512i secondLanes = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+
+    int i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i cell = _mm512_loadu_si512(cells + i);
+        __mmask64 upperHalf = _mm512_movepi8_mask(cell);
+
+        __m512i low = _mm512_mask_blend_epi8(upperHalf,
+                                             _mm512_permutex2var_epi8(lowBytes0, cell, lowBytes1),
+                                             _mm512_permutex2var_epi8(lowBytes2, cell, lowBytes3));
+        __m512i high = _mm512_setzero_si512();
+        if (!Latin1) {
+            high = _mm512_mask_blend_epi8(upperHalf,
+                                          _mm512_permutex2var_epi8(highBytes0, cell, highBytes1),
+                                          _mm512_permutex2var_epi8(highBytes2, cell, highBytes3));
+        }
+
+        __m512i first = _mm512_unpacklo_epi8(low, high);
+        __m512i second = _mm512_unpackhi_epi8(low, high);
+        _mm512_storeu_si512(text + i, _mm512_permutex2var_epi64(first, firstLanes, second));
+        _mm512_storeu_si512(text + i + 32, _mm512_permutex2var_epi64(first, secondLanes, second));
+    }
+
+    cellsToUnicodeScalar(table, cells + i, size - i, text + i);
+}
+
+__attribute__((target("avx512bw,avx512vbmi")))
+static void convertVbmi(const DisplayTable &table, const unsigned char *cells, int size, ushort *text)
+{
+    table.latin1 ? cellsToUnicodeVbmi<true>(table, cells, size, text)
+                 : cellsToUnicodeVbmi<false>(table, cells, size, text);
+}
+
+static ConvertFunction selectVectorFunction()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi")) {
+        return convertVbmi;
+    }
+    return nullptr;
+}
+
+#else
+
+static ConvertFunction selectVectorFunction()
+{
+    return nullptr;
+}
+
+#endif
+
+static ConvertFunction vectorFunction()
+{
+    static const ConvertFunction convert = selectVectorFunction();
+    return convert;
+}
+
+const EbcdicCodec *EbcdicCodec::codecForCcsid(int ccsid)
+{
+    for (const EbcdicCodec &codec : Codecs) {
+        if (codec.ccsid() == ccsid) {
+            return &codec;
+        }
+    }
+
+    return nullptr;
+}
+
+QString EbcdicCodec::toUnicode(const QByteArray &ebcdic) const
+{
+    QString text;
+    text.reserve(ebcdic.size());
+
+    for (int i = 0; i < ebcdic.size(); ++i) {
+        text += toUnicode(ebcdic.at(i));
+    }
+
+    return text;
+}
+
+QByteArray EbcdicCodec::fromUnicode(const QString &text) const
+{
+    QByteArray ebcdic;
+    ebcdic.resize(text.size());
+    char *data = ebcdic.data();
+
+    for (int i = 0; i < text.size(); ++i) {
+        data[i] = fromUnicode(text.at(i));
+    }
+
+    return ebcdic;
+}
+
+bool EbcdicCodec::hasVectorCellConversion()
+{
+    return vectorFunction() != nullptr;
+}
+
+void EbcdicCodec::cellsToUnicode(const unsigned char *cells, int size, QChar *text, CellConversion conversion) const
+{
+    ushort *out = reinterpret_cast<ushort*>(text);
+
+    const DisplayTable *tables = displayTables();
+    const std::less<const EbcdicCodec*> before;
+    if (before(this, Codecs) || !before(this, Codecs + CodecCount)) {
+        // not one of the static codecs
+        DisplayTable table;
+        buildDisplayTable(*this, table);
+        cellsToUnicodeScalar(table, cells, size, out);
+        return;
+    }
+
+    const DisplayTable &table = tables[this - Codecs];
+    const ConvertFunction convert = vectorFunction();
+
+    if (conversion == CellConversion::Scalar || !convert
+            || (conversion == CellConversion::Fastest && size < MinimumVectorSize)) {
+        cellsToUnicodeScalar(table, cells, size, out);
+        return;
+    }
+
+    convert(table, cells, size, out);
+}
+
+unsigned char EbcdicCodec::fromUnicodeMapping(ushort unicode) const
+{
+    const Mapping *end = fromUnicodeMappings + fromUnicodeMappingCount;
+    const Mapping *mapping = std::lower_bound(fromUnicodeMappings, end, unicode,
+                                              [](const Mapping &lhs, ushort rhs) { return lhs.unicode < rhs; });
+
+    return mapping != end && mapping->unicode == unicode ? mapping->ebcdic : EbcdicQuestionMark;
+}
+
+} // namespace q5250
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_EBCDICCODEC_H
+#define Q5250_EBCDICCODEC_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace q5250 {
+
+/*
+ * Translates between an EBCDIC code page and UTF-16 with static tables.
+ *
+ * Each codec has a 256 entry table to UTF-16, a 256 entry table from
+ * Latin-1 and a short sorted list for the few characters above U+00FF
+ * (e.g. the euro sign of the CCSIDs 1140 to 1149). Characters without a
+ * mapping translate to '?'.
+ */
+class Q5250SHARED_EXPORT EbcdicCodec
+{
+public:
+    struct Mapping
+    {
+        ushort unicode;
+        unsigned char ebcdic;
+    };
+
+    constexpr EbcdicCodec(int ccsid, const ushort *toUnicodeTable, const unsigned char *fromLatin1Table,
+                          const Mapping *fromUnicodeMappings, int fromUnicodeMappingCount) :
+        id(ccsid),
+        toUnicodeTable(toUnicodeTable),
+        fromLatin1Table(fromLatin1Table),
+        fromUnicodeMappings(fromUnicodeMappings),
+        fromUnicodeMappingCount(fromUnicodeMappingCount)
+    {
+    }
+
+    // returns a null pointer for an unsupported CCSID
+    static const EbcdicCodec *codecForCcsid(int ccsid);
+
+    int ccsid() const { return id; }
+
+    QChar toUnicode(unsigned char ebcdic) const { return QChar(toUnicodeTable[ebcdic]); }
+    QString toUnicode(const QByteArray &ebcdic) const;
+
+    unsigned char fromUnicode(QChar character) const
+    {
+        ushort unicode = character.unicode();
+        return unicode <= 0xff ? fromLatin1Table[unicode] : fromUnicodeMapping(unicode);
+    }
+    QByteArray fromUnicode(const QString &text) const;
+
+    enum class CellConversion { Fastest, Scalar, Vector };
+
+    // Translates display cells into the caller's buffer of at least size
+    // characters. Attribute bytes (0x20-0x3f) and NULs become blanks.
+    // Fastest uses the vector path (AVX-512 VBMI) for runs long enough to
+    // pay off, the other values force one path for benchmarks. Without
+    // CPU support (see hasVectorCellConversion()) Vector runs the scalar loop.
+    void cellsToUnicode(const unsigned char *cells, int size, QChar *text,
+                        CellConversion conversion = CellConversion::Fastest) const;
+    static bool hasVectorCellConversion();
+
+private:
+    unsigned char fromUnicodeMapping(ushort unicode) const;
+
+    int id;
+    const ushort *toUnicodeTable;
+    const unsigned char *fromLatin1Table;
+    const Mapping *fromUnicodeMappings;
+    int fromUnicodeMappingCount;
+};
+
+} // namespace q5250
+
+#endif // Q5250_EBCDICCODEC_H
@@ -26,22 +26,38 @@
 #ifndef Q5250_FORMATTABLE_H
 #define Q5250_FORMATTABLE_H
 
+#include <functional>
+
 namespace q5250 {
 
 class Cursor;
 struct Field;
 
+/*
+ * Fields are identified by the id returned from append(). The ids stay
+ * valid until the next clear().
+ */
 class FormatTable
 {
 public:
+    enum { NoField = -1 };
+
     virtual void clear() = 0;
-    virtual void append(Field *field) = 0;
+    virtual int append(const Field &field) = 0;
+
+    virtual Field &field(int fieldId) = 0;
+
+    virtual int fieldAt(const Cursor &cursor, int displayWidth) const = 0;
+    virtual int nextInputField(const Cursor &cursor) const = 0;
+    virtual int previousInputField(const Cursor &cursor) const = 0;
 
-    virtual Field* fieldAt(const Cursor &cursor, int displayWidth) const = 0;
+    virtual void markAsModified(int fieldId) = 0;
+    virtual bool isModified() const = 0;
 
     virtual bool isEmpty() const = 0;
 
-    virtual void map(std::function<void (Field*)> func) const = 0;
+    virtual void map(std::function<void (const Field &)> func) const = 0;
+    virtual void mapModified(std::function<void (const Field &)> func) const = 0;
 };
 
 } // namespace q5250
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "protocoltrace.h"
+
+#include <QIODevice>
+
+namespace q5250 {
+
+Q_LOGGING_CATEGORY(lcTerminal, "q5250.terminal")
+Q_LOGGING_CATEGORY(lcProtocolTrace, "q5250.protocol.trace")
+
+namespace {
+const int FlushThreshold = 4096;
+}
+
+ProtocolTrace::ProtocolTrace() :
+    device(nullptr)
+{
+}
+
+ProtocolTrace::~ProtocolTrace()
+{
+    flush();
+}
+
+void ProtocolTrace::setDevice(QIODevice *device)
+{
+    flush();
+    this->device = device;
+    buffer.reserve(FlushThreshold + RecordSize);
+}
+
+bool ProtocolTrace::isEnabled() const
+{
+    return device && lcProtocolTrace().isDebugEnabled();
+}
+
+void ProtocolTrace::record(unsigned char order, unsigned char argument1, unsigned char argument2, unsigned short length)
+{
+    const char record[RecordSize] {
+        char(order), char(argument1), char(argument2), char(length >> 8), char(length)
+    };
+    buffer.append(record, RecordSize);
+
+    if (buffer.size() >= FlushThreshold) {
+        flush();
+    }
+}
+
+void ProtocolTrace::flush()
+{
+    if (device && !buffer.isEmpty()) {
+        device->write(buffer);
+    }
+    buffer.resize(0);
+}
+
+} // namespace q5250
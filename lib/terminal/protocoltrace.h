@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_PROTOCOLTRACE_H
+#define Q5250_PROTOCOLTRACE_H
+
+#include "q5250_global.h"
+
+#include <QByteArray>
+#include <QLoggingCategory>
+
+class QIODevice;
+
+namespace q5250 {
+
+Q_DECLARE_LOGGING_CATEGORY(lcTerminal)
+Q_DECLARE_LOGGING_CATEGORY(lcProtocolTrace)
+
+/*
+ * Binary trace of the received 5250 orders.
+ *
+ * Each order is written as a five byte record: the order byte, two
+ * order specific argument bytes (mostly row and column) and a big
+ * endian length. Runs of data bytes are written as a single record
+ * with order byte 0x00 and the run length.
+ *
+ * Records are only collected while a device is set and the
+ * q5250.protocol.trace category is enabled for debug messages. The
+ * Q5250_TRACE macro compiles to nothing unless the library is built
+ * with Q5250_WITH_PROTOCOL_TRACE.
+ */
+class Q5250SHARED_EXPORT ProtocolTrace
+{
+public:
+    static const int RecordSize = 5;
+
+    ProtocolTrace();
+    ~ProtocolTrace();
+
+    void setDevice(QIODevice *device);
+    bool isEnabled() const;
+
+    void record(unsigned char order, unsigned char argument1, unsigned char argument2, unsigned short length = 0);
+    void flush();
+
+private:
+    Q_DISABLE_COPY(ProtocolTrace)
+
+    QIODevice *device;
+    QByteArray buffer;
+};
+
+} // namespace q5250
+
+#ifdef Q5250_WITH_PROTOCOL_TRACE
+#define Q5250_TRACE(trace, ...) \
+    do { if ((trace).isEnabled()) (trace).record(__VA_ARGS__); } while (false)
+#else
+#define Q5250_TRACE(trace, ...) \
+    do { } while (false)
+#endif
+
+#endif // Q5250_PROTOCOLTRACE_H
@@ -34,6 +34,7 @@ class TerminalDisplay
 {
 public:
     virtual void clear() = 0;
+    virtual void clearArea(unsigned char column, unsigned char row, unsigned char columns, unsigned char rows) = 0;
     virtual void displayText(unsigned char column, unsigned char row, const QString &text) = 0;
     virtual void displayAttribute(unsigned char attribute) = 0;
     virtual void displayCursor(unsigned char column, unsigned char row) = 0;
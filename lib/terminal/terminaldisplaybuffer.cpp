@@ -25,12 +25,20 @@
  */
 #include "terminaldisplaybuffer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <QByteArray>
 
+#include "ebcdiccodec.h"
 #include "field.h"
 
 namespace q5250 {
 
+static inline bool isAttribute(unsigned char character)
+{
+    return (character & 0xe0) == 0x20;
+}
+
 TerminalDisplayBuffer::TerminalDisplayBuffer() :
     addressColumn(1),
     addressRow(1),
@@ -57,6 +65,12 @@ void TerminalDisplayBuffer::setSize(unsigned char columns, unsigned char rows)
     bufferSize.setHeight(rows);
 
     buffer = new QByteArray(columns*rows, '\0');
+
+    damagedRows.assign(rows, false);
+    damagedSpans.resize(rows);
+    if (!buffer->isEmpty()) {
+        damage(0, buffer->size() - 1);
+    }
 }
 
 unsigned char TerminalDisplayBuffer::bufferColumn() const
@@ -81,33 +95,77 @@ unsigned char TerminalDisplayBuffer::characterAt(unsigned char column, unsigned
     return buffer->at(address);
 }
 
+const unsigned char *TerminalDisplayBuffer::rowCells(unsigned char row) const
+{
+    const unsigned char *cells = reinterpret_cast<const unsigned char*>(buffer->constData());
+    return cells + convertToAddress(1, row);
+}
+
 void TerminalDisplayBuffer::setCharacter(unsigned char character)
 {
     setCharacterAt(addressColumn, addressRow, character);
     increaseBufferAddress();
 }
 
+void TerminalDisplayBuffer::writeRun(const unsigned char *data, size_t size)
+{
+    const size_t bufferLength = buffer->size();
+    if (size == 0 || bufferLength == 0) {
+        return;
+    }
+
+    size_t address = convertToAddress(addressColumn, addressRow) % bufferLength;
+    char *bufferData = buffer->data();
+
+    // copy up to the end of the buffer, then continue at the first row
+    while (size > 0) {
+        const size_t chunkSize = std::min(size, bufferLength - address);
+        if (memcmp(bufferData + address, data, chunkSize) != 0) {
+            memcpy(bufferData + address, data, chunkSize);
+            damageToEndOfRow(address, address + chunkSize - 1);
+        }
+
+        data += chunkSize;
+        size -= chunkSize;
+        address = (address + chunkSize) % bufferLength;
+    }
+
+    setAddress(address);
+}
+
 void TerminalDisplayBuffer::setCharacterAt(unsigned char increment, unsigned char character)
 {
     unsigned int address = convertToAddress(addressColumn, addressRow);
-    (*buffer)[address+increment] = character;
+    setCell(address+increment, character);
 }
 
 void TerminalDisplayBuffer::setCharacterAt(unsigned char column, unsigned char row, unsigned char character)
 {
     unsigned int address = convertToAddress(column, row);
-    (*buffer)[address] = character;
+    setCell(address, character);
 }
 
 void TerminalDisplayBuffer::repeatCharacterToAddress(unsigned char column, unsigned char row, unsigned char character)
 {
-    unsigned int fromAddress = convertToAddress(addressColumn, addressRow);
-    unsigned int toAddress = convertToAddress(column, row);
-    unsigned int numberOfCharacters = toAddress - fromAddress + 1;
+    const unsigned int bufferLength = buffer->size();
+    if (bufferLength == 0) {
+        return;
+    }
 
-    for (int i = 0; i < numberOfCharacters; ++i) {
-        setCharacter(character);
+    unsigned int fromAddress = convertToAddress(addressColumn, addressRow) % bufferLength;
+    unsigned int toAddress = convertToAddress(column, row) % bufferLength;
+    char *bufferData = buffer->data();
+
+    // an end address before the start address wraps past the end of the buffer
+    if (toAddress < fromAddress) {
+        memset(bufferData + fromAddress, character, bufferLength - fromAddress);
+        damageToEndOfRow(fromAddress, bufferLength - 1);
+        fromAddress = 0;
     }
+    memset(bufferData + fromAddress, character, toAddress - fromAddress + 1);
+    damageToEndOfRow(fromAddress, toAddress);
+
+    setAddress((toAddress + 1) % bufferLength);
 }
 
 void TerminalDisplayBuffer::addField(Field *field)
@@ -143,11 +201,91 @@ QByteArray TerminalDisplayBuffer::fieldContent(const Field *field) const
     return content.replace('\0', '\x40');
 }
 
+void TerminalDisplayBuffer::rowToUnicode(unsigned char row, const EbcdicCodec *codec, QChar *text) const
+{
+    codec->cellsToUnicode(rowCells(row), bufferSize.width(), text);
+}
+
+void TerminalDisplayBuffer::toUnicode(const EbcdicCodec *codec, QChar *text) const
+{
+    const unsigned char *cells = reinterpret_cast<const unsigned char*>(buffer->constData());
+    codec->cellsToUnicode(cells, buffer->size(), text);
+}
+
+bool TerminalDisplayBuffer::damagedColumns(unsigned char row, unsigned char &firstColumn, unsigned char &lastColumn) const
+{
+    if (row < 1 || row > damagedRows.size() || !damagedRows[row-1]) {
+        return false;
+    }
+
+    firstColumn = damagedSpans[row-1].firstColumn;
+    lastColumn = damagedSpans[row-1].lastColumn;
+    return true;
+}
+
+void TerminalDisplayBuffer::clearDamage()
+{
+    std::fill(damagedRows.begin(), damagedRows.end(), false);
+}
+
 unsigned int TerminalDisplayBuffer::convertToAddress(unsigned char column, unsigned char row) const
 {
     return (row-1) * bufferSize.width() + (column-1);
 }
 
+void TerminalDisplayBuffer::setAddress(unsigned int address)
+{
+    addressColumn = address % bufferSize.width() + 1;
+    addressRow    = address / bufferSize.width() + 1;
+}
+
+void TerminalDisplayBuffer::setCell(unsigned int address, unsigned char character)
+{
+    if (address >= (unsigned int)buffer->size()) {
+        return;
+    }
+
+    const unsigned char previous = buffer->at(address);
+    if (previous == character) {
+        return;
+    }
+
+    (*buffer)[address] = character;
+
+    if (isAttribute(previous) || isAttribute(character)) {
+        damageToEndOfRow(address, address);
+    } else {
+        damage(address, address);
+    }
+}
+
+// Merges the cells from fromAddress to toAddress into the damaged span of each row.
+void TerminalDisplayBuffer::damage(unsigned int fromAddress, unsigned int toAddress)
+{
+    const unsigned int width = bufferSize.width();
+
+    for (unsigned int row = fromAddress / width; row <= toAddress / width; ++row) {
+        const unsigned char firstColumn = row == fromAddress / width ? fromAddress % width + 1 : 1;
+        const unsigned char lastColumn = row == toAddress / width ? toAddress % width + 1 : width;
+
+        ColumnSpan &span = damagedSpans[row];
+        if (damagedRows[row]) {
+            span.firstColumn = std::min(span.firstColumn, firstColumn);
+            span.lastColumn = std::max(span.lastColumn, lastColumn);
+        } else {
+            span.firstColumn = firstColumn;
+            span.lastColumn = lastColumn;
+            damagedRows[row] = true;
+        }
+    }
+}
+
+void TerminalDisplayBuffer::damageToEndOfRow(unsigned int fromAddress, unsigned int toAddress)
+{
+    const unsigned int width = bufferSize.width();
+    damage(fromAddress, toAddress / width * width + width - 1);
+}
+
 void TerminalDisplayBuffer::increaseBufferAddress(unsigned char increment)
 {
     // FIXME: Needs unit test!
@@ -29,10 +29,14 @@
 #include "q5250_global.h"
 #include "displaybuffer.h"
 
+#include <vector>
+
 class QByteArray;
+class QChar;
 
 namespace q5250 {
 
+class EbcdicCodec;
 struct Field;
 
 class Q5250SHARED_EXPORT TerminalDisplayBuffer : public DisplayBuffer
@@ -49,7 +53,9 @@ public:
     void setBufferAddress(unsigned char column, unsigned char row);
 
     unsigned char characterAt(unsigned char column, unsigned char row) const;
+    const unsigned char *rowCells(unsigned char row) const;
     void setCharacter(unsigned char character);
+    void writeRun(const unsigned char *data, size_t size);
     void setCharacterAt(unsigned char increment, unsigned char character);
     void setCharacterAt(unsigned char column, unsigned char row, unsigned char character);
     void repeatCharacterToAddress(unsigned char column, unsigned char row, unsigned char character);
@@ -57,14 +63,37 @@ public:
     void addField(Field *field);
     QByteArray fieldContent(const Field *field) const;
 
+    // Data runs and writes of or over an attribute byte damage the rest of
+    // the row, since attributes change how the following cells are shown.
+    bool damagedColumns(unsigned char row, unsigned char &firstColumn, unsigned char &lastColumn) const;
+    void clearDamage();
+
+    // Translate the cells of one row (width characters) or of the whole
+    // buffer (width * height characters) into the caller's buffer, see
+    // EbcdicCodec::cellsToUnicode().
+    void rowToUnicode(unsigned char row, const EbcdicCodec *codec, QChar *text) const;
+    void toUnicode(const EbcdicCodec *codec, QChar *text) const;
+
 private:
     unsigned int convertToAddress(unsigned char column, unsigned char row) const;
     void increaseBufferAddress(unsigned char increment = 1);
+    void setAddress(unsigned int address);
+    void setCell(unsigned int address, unsigned char character);
+    void damage(unsigned int fromAddress, unsigned int toAddress);
+    void damageToEndOfRow(unsigned int fromAddress, unsigned int toAddress);
+
+    struct ColumnSpan
+    {
+        unsigned char firstColumn;
+        unsigned char lastColumn;
+    };
 
     unsigned char addressColumn;
     unsigned char addressRow;
     QSize bufferSize;
     QByteArray *buffer;
+    std::vector<bool> damagedRows;
+    std::vector<ColumnSpan> damagedSpans;
 };
 
 } // namespace q5250
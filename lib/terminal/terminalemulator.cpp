@@ -27,25 +27,89 @@
 
 #include <QDebug>
 #include <QEvent>
-#include <QTextCodec>
+
+#include <algorithm>
 
 #include "displaybuffer.h"
+#include "ebcdiccodec.h"
 #include "field.h"
 #include "formattable.h"
 #include "generaldatastream.h"
+#include "protocoltrace.h"
 #include "terminaldisplay.h"
+#include "wtdorder.h"
 
 namespace q5250 {
 
+namespace {
+
+// [ROW] [COLUMN] [AID] at the start of an input response
+struct ResponseHeader
+{
+    quint8 row;
+    quint8 column;
+    quint8 aid;
+};
+
+// [SBA] [ROW] [COLUMN] in front of each field in an input response
+struct SetBufferAddress
+{
+    quint8 order;
+    quint8 row;
+    quint8 column;
+};
+
+
+static const unsigned char ReadInputFieldsCommand = 0x42;
+static const unsigned char ReadMdtFieldsCommand = 0x52;
+static const unsigned char ReadImmediateCommand = 0x72;
+static const unsigned char ReadMdtFieldsAltCommand = 0x82;
+
+static const unsigned char NormalAttribute = 0x20;
+
+// CC2 bit of WRITE TO DISPLAY
+static const unsigned char UnlockKeyboard = 0x08;
+
+static inline bool isAttribute(unsigned char character)
+{
+    return character >= 0x20 && character <= 0x3f;
+}
+
+}
+
 TerminalEmulator::TerminalEmulator(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    fullUpdate(true),
+    updatePending(false),
+    keyboardUnlocked(false),
+    readCommand(ReadMdtFieldsCommand)
+{
+    codec = EbcdicCodec::codecForCcsid(500);
+
+    frameTimer.setSingleShot(true);
+    connect(&frameTimer, &QTimer::timeout, this, &TerminalEmulator::update);
+}
+
+bool TerminalEmulator::setCcsid(int ccsid)
+{
+    const EbcdicCodec *ccsidCodec = EbcdicCodec::codecForCcsid(ccsid);
+    if (!ccsidCodec) {
+        return false;
+    }
+
+    codec = ccsidCodec;
+    return true;
+}
+
+int TerminalEmulator::ccsid() const
 {
-    codec = QTextCodec::codecForName("IBM500");
+    return codec->ccsid();
 }
 
 void TerminalEmulator::setDisplayBuffer(DisplayBuffer *buffer)
 {
     displayBuffer = buffer;
+    fullUpdate = true;
 }
 
 void TerminalEmulator::setFormatTable(FormatTable *table)
@@ -56,6 +120,22 @@ void TerminalEmulator::setFormatTable(FormatTable *table)
 void TerminalEmulator::setTerminalDisplay(TerminalDisplay *display)
 {
     terminalDisplay = display;
+    fullUpdate = true;
+}
+
+void TerminalEmulator::setTraceDevice(QIODevice *device)
+{
+    trace.setDevice(device);
+}
+
+void TerminalEmulator::setFrameInterval(int msec)
+{
+    frameTimer.setInterval(msec);
+}
+
+int TerminalEmulator::frameInterval() const
+{
+    return frameTimer.interval();
 }
 
 Cursor TerminalEmulator::cursorPosition() const
@@ -80,6 +160,17 @@ void TerminalEmulator::parseStreamData(const QByteArray &data)
             case 0x40 /*CLEAR UNIT*/:
                 handleClearUnitCommand();
                 break;
+            case ReadInputFieldsCommand:
+            case ReadMdtFieldsCommand:
+            case ReadMdtFieldsAltCommand:
+                // the fields are read with the next AID key
+                readCommand = byte;
+                stream.readWord();  // CC1, CC2
+                keyboardUnlocked = true;
+                break;
+            case ReadImmediateCommand:
+                sendFields(ReadImmediateCommand, 0x00 /*no AID*/);
+                break;
             case 0xf3 /*WRITE STRUCTURED FIELD*/:
                 handleWriteStructuredFieldCommand(stream);
                 break;
@@ -103,34 +194,23 @@ void TerminalEmulator::handleKeypress(int key, const QString &text)
     case Qt::Key_Right:
         cursor.moveRight();
         break;
+    case Qt::Key_Tab:
+        moveCursorToField(formatTable->nextInputField(cursor));
+        break;
+    case Qt::Key_Backtab:
+        moveCursorToField(formatTable->previousInputField(cursor));
+        break;
     case Qt::Key_Return:
-        {
-            GeneralDataStream stream;
-
-            stream << cursor.row() << cursor.column() << 0xf1 /*AID*/;
-
-            formatTable->map([&](Field* field) {
-                stream << 0x11
-                       << field->startRow
-                       << field->startColumn;
-
-                QByteArray content = displayBuffer->fieldContent(field);
-                for (int i = 0; i < content.size(); ++i) {
-                    stream << content.at(i);
-                }
-            });
-
-            emit sendData(stream.toByteArray());
-        }
+        sendFields(readCommand, 0xf1 /*AID*/);
         break;
     default:
         if (!text.isEmpty()) {
-            Field *currentField = formatTable->fieldAt(cursor, displayBuffer->size().width());
+            int fieldId = formatTable->fieldAt(cursor, displayBuffer->size().width());
 
-            if (currentField && !currentField->isBypassField()) {
-                QByteArray ebcdic = codec->fromUnicode(text);
-                displayBuffer->setCharacterAt(cursor.column(), cursor.row(), ebcdic.at(0));
-                currentField->markAsModified();
+            if (fieldId != FormatTable::NoField && !formatTable->field(fieldId).isBypassField()) {
+                unsigned char ebcdic = codec->fromUnicode(text.at(0));
+                displayBuffer->setCharacterAt(cursor.column(), cursor.row(), ebcdic);
+                formatTable->markAsModified(fieldId);
                 cursor.moveRight();
             }
         }
@@ -138,53 +218,204 @@ void TerminalEmulator::handleKeypress(int key, const QString &text)
     }
 }
 
+void TerminalEmulator::sendFields(unsigned char command, unsigned char aid)
+{
+    GeneralDataStream &stream = beginReply();
+    stream.reserve(displayBuffer->size().width() * displayBuffer->size().height());
+
+    const ResponseHeader header { cursor.row(), cursor.column(), aid };
+    stream.appendStruct(header);
+
+    if (command == ReadInputFieldsCommand || command == ReadImmediateCommand) {
+        // the content of all input fields without address, if any of them was modified
+        if (formatTable->isModified()) {
+            formatTable->map([&](const Field &field) {
+                if (!field.isInputField()) {
+                    return;
+                }
+
+                QByteArray content = displayBuffer->fieldContent(&field);
+                stream.append(content.constData(), content.size());
+                for (int i = content.size(); i < field.length; ++i) {
+                    stream << quint8(0x40);
+                }
+            });
+        }
+    } else {
+        formatTable->mapModified([&](const Field &field) {
+            const SetBufferAddress address { 0x11, field.startRow, field.startColumn };
+            stream.appendStruct(address);
+
+            QByteArray content = displayBuffer->fieldContent(&field);
+            stream.append(content.constData(), content.size());
+        });
+    }
+
+    emit sendData(stream.toByteArray());
+}
+
+void TerminalEmulator::moveCursorToField(int fieldId)
+{
+    if (fieldId != FormatTable::NoField) {
+        const Field &field = formatTable->field(fieldId);
+        cursor.setPosition(field.startColumn, field.startRow);
+    }
+}
+
 void TerminalEmulator::dataReceived(const QByteArray &data)
 {
-    parseStreamData(data);
-    update();
+    keyboardUnlocked = false;
+
+    bool wellFormed = recordFramer.frame(data, [this](const QByteArray &record) {
+        parseStreamData(record);
+    });
+
+    if (!wellFormed) {
+        qCWarning(lcTerminal) << "Dropped received data with malformed GDS header";
+    }
+
+    // the screens in between are only seen for a frame, if at all
+    if (keyboardUnlocked || frameTimer.interval() == 0) {
+        update();
+    } else if (!updatePending) {
+        updatePending = true;
+        frameTimer.start();
+    }
 }
 
 void TerminalEmulator::update()
 {
-    QByteArray text;
-
-    unsigned char startColumn = 0;
-    unsigned char startRow = 0;
+    updatePending = false;
+    frameTimer.stop();
 
     int bufferWidth = displayBuffer->size().width();
     int bufferHeight = displayBuffer->size().height();
+    textRun.reserve(bufferWidth);
+    textPart.reserve(bufferWidth);
+
+    // repaint everything after a resize or redraw(), otherwise only the damage
+    const bool repaintAll = fullUpdate || displaySize != QSize(bufferWidth, bufferHeight);
+    if (repaintAll) {
+        terminalDisplay->clear();
+        displaySize = QSize(bufferWidth, bufferHeight);
+        rowAttributes.assign(bufferHeight, NormalAttribute);
+        fullUpdate = false;
+    }
 
-    terminalDisplay->clear();
-
-    for (int row = 0; row < bufferHeight; ++row) {
-        for (int column = 0; column < bufferWidth; ++column) {
-            unsigned char character = displayBuffer->characterAt(column+1, row+1);
-            if (character >= 0x20 && character <= 0x3f) {
-                if (text.length() > 0) {
-                    terminalDisplay->displayText(startColumn, startRow, codec->toUnicode(text));
-                    text.clear();
+    // attribute in effect at the start of the row
+    unsigned char attribute = NormalAttribute;
+    bool attributeChanged = false;
+
+    for (int row = 1; row <= bufferHeight; ++row) {
+        int firstColumn = 1;
+        int lastColumn = bufferWidth;
+
+        // a changed attribute at the end of the previous row affects this whole row
+        if (!repaintAll && !attributeChanged) {
+            unsigned char damagedFirstColumn = 0;
+            unsigned char damagedLastColumn = 0;
+            bool damaged = displayBuffer->damagedColumns(row, damagedFirstColumn, damagedLastColumn);
+            firstColumn = damagedFirstColumn;
+            lastColumn = damagedLastColumn;
+
+            // erase the old cursor and draw the cell under the new one
+            const bool cursorMoved = drawnCursor.column() != cursor.column() || drawnCursor.row() != cursor.row();
+            for (const Cursor &damagedCursor : { drawnCursor, cursor }) {
+                if (!cursorMoved || damagedCursor.row() != row ||
+                    damagedCursor.column() < 1 || damagedCursor.column() > bufferWidth) {
+                    continue;
                 }
-                terminalDisplay->displayAttribute(character);
-            } else {
-                if (text.isEmpty()) {
-                    startColumn = column+1;
-                    startRow = row+1;
-                }
-                text += (character == '\0' ? '\x40': character);
+                firstColumn = damaged ? std::min<int>(firstColumn, damagedCursor.column()) : damagedCursor.column();
+                lastColumn = damaged ? std::max<int>(lastColumn, damagedCursor.column()) : damagedCursor.column();
+                damaged = true;
+            }
+
+            if (!damaged) {
+                attribute = rowAttributes[row-1];
+                continue;
             }
         }
 
-        if (text.length() > 0) {
-            terminalDisplay->displayText(startColumn, startRow, codec->toUnicode(text));
-            text.clear();
+        const unsigned char endAttribute = drawRow(row, firstColumn, lastColumn, attribute, !repaintAll);
+        attributeChanged = lastColumn == bufferWidth && endAttribute != rowAttributes[row-1];
+        if (lastColumn == bufferWidth) {
+            rowAttributes[row-1] = endAttribute;
         }
+        attribute = rowAttributes[row-1];
     }
 
+    displayBuffer->clearDamage();
+
     terminalDisplay->displayCursor(cursor.column(), cursor.row());
+    drawnCursor = cursor;
 
     emit updateFinished();
 }
 
+void TerminalEmulator::redraw()
+{
+    fullUpdate = true;
+    update();
+}
+
+// Draws the cells from firstColumn to lastColumn and returns the attribute in
+// effect after them. A partial redraw clears the cells first and restores the
+// attribute they are shown with.
+unsigned char TerminalEmulator::drawRow(unsigned char row, int firstColumn, int lastColumn,
+                                        unsigned char attribute, bool partial)
+{
+    const unsigned char *cells = displayBuffer->rowCells(row);
+
+    for (int column = 1; column < firstColumn; ++column) {
+        if (isAttribute(cells[column - 1])) {
+            attribute = cells[column - 1];
+        }
+    }
+
+    if (partial) {
+        terminalDisplay->clearArea(firstColumn, row, lastColumn - firstColumn + 1, 1);
+        terminalDisplay->displayAttribute(attribute);
+    }
+
+    // translate the whole span at once, attributes and NULs come out as
+    // blanks, so the loop below only has to split it at the attributes
+    const unsigned char *span = cells + firstColumn - 1;
+    const int spanLength = lastColumn - firstColumn + 1;
+    textRun.resize(spanLength);
+    codec->cellsToUnicode(span, spanLength, textRun.data());
+
+    int start = 0;
+    for (int index = 0; index < spanLength; ++index) {
+        if (isAttribute(span[index])) {
+            drawText(firstColumn + start, row, start, index);
+            terminalDisplay->displayAttribute(span[index]);
+            attribute = span[index];
+            start = index + 1;
+        }
+    }
+    drawText(firstColumn + start, row, start, spanLength);
+
+    return attribute;
+}
+
+// Shows textRun[start, end) at column, copying into textPart only when the
+// run does not cover all of textRun. Both keep their capacity between updates.
+void TerminalEmulator::drawText(unsigned char column, unsigned char row, int start, int end)
+{
+    if (start >= end) {
+        return;
+    }
+
+    if (start == 0 && end == textRun.size()) {
+        terminalDisplay->displayText(column, row, textRun);
+        return;
+    }
+
+    textPart.resize(0);
+    textPart.append(textRun.constData() + start, end - start);
+    terminalDisplay->displayText(column, row, textPart);
+}
+
 void TerminalEmulator::keyPressed(int key, const QString &text)
 {
     handleKeypress(key, text);
@@ -198,97 +429,160 @@ void TerminalEmulator::handleClearUnitCommand()
     cursor.setPosition(1, 1);
 }
 
+// All replies are built in the same stream, so its buffer
+// is reused once the previous reply has been sent.
+GeneralDataStream &TerminalEmulator::beginReply()
+{
+    replyStream.clear();
+    return replyStream;
+}
+
 void TerminalEmulator::handleWriteToDisplayCommand(GeneralDataStream &stream)
 {
     unsigned char cc1 = stream.readByte();
     unsigned char cc2 = stream.readByte();
 
-    qDebug() << "[WTD] cc1 =" << bin << showbase << cc1
-             << "cc2 =" << bin << showbase << cc2;
+    qCDebug(lcTerminal) << "[WTD] cc1 =" << bin << showbase << cc1
+                        << "cc2 =" << bin << showbase << cc2;
+
+    if (cc2 & UnlockKeyboard) {
+        keyboardUnlocked = true;
+    }
 
     while (!stream.atEnd()) {
-        unsigned char byte = stream.readByte();
+        const char *data = stream.readPointer();
+        const char *dataEnd = data;
+        while (dataEnd != stream.endPointer() && wtdOrder(*dataEnd) == WtdOrder::Data) {
+            ++dataEnd;
+        }
+
+        if (dataEnd != data) {
+            Q5250_TRACE(trace, 0x00, 0, 0, dataEnd - data);
+            writeData(data, dataEnd - data);
+            stream.skip(dataEnd - data);
+            continue;
+        }
 
-        char ch = (char)byte;
-        qDebug() << "[WTD] order/data =" << codec->toUnicode(&ch, 1) << hex << showbase << byte;
+        unsigned char byte = stream.readByte();
 
-        switch (byte) {
-        case 0x01 /*START OF HEADER*/:
+        switch (wtdOrder(byte)) {
+        case WtdOrder::StartOfHeader:
             {
                 unsigned dataLength = stream.readByte();
                 formatTable->clear();
-                qDebug() << "[WTD:SOH]";
+                Q5250_TRACE(trace, byte, 0, 0, dataLength);
             }
             break;
-        case 0x02 /*REPEAT TO ADDRESS*/:
+        case WtdOrder::RepeatToAddress:
             {
                 unsigned char row = stream.readByte();
                 unsigned char column = stream.readByte();
                 unsigned char character = stream.readByte();
                 displayBuffer->repeatCharacterToAddress(column, row, character);
-                qDebug() << "[WTD:RA ]";
+                Q5250_TRACE(trace, byte, row, column, character);
+            }
+            break;
+        case WtdOrder::EraseToAddress:
+            {
+                unsigned char row = stream.readByte();
+                unsigned char column = stream.readByte();
+                unsigned char length = stream.readByte();
+                // attribute types to erase, only the display characters are supported
+                stream.skip(qMax(length - 1, 0));
+                displayBuffer->repeatCharacterToAddress(column, row, 0x00);
+                Q5250_TRACE(trace, byte, row, column, length);
             }
             break;
-        case 0x04 /*ESC*/:
+        case WtdOrder::Escape:
             stream.seekToPreviousByte();
             return;
-        case 0x11 /*SET BUFFER ADDRESS*/:
+        case WtdOrder::TransparentData:
+            {
+                unsigned short length = stream.readWord();
+                const char *transparentData = stream.readPointer();
+                int size = qMin<int>(length, stream.endPointer() - transparentData);
+                writeData(transparentData, size);
+                stream.skip(size);
+                Q5250_TRACE(trace, byte, 0, 0, length);
+            }
+            break;
+        case WtdOrder::SetBufferAddress:
             {
                 unsigned char row = stream.readByte();
                 unsigned char column = stream.readByte();
                 displayBuffer->setBufferAddress(column, row);
-                qDebug() << "[WTD:SBA] row =" << row << "column =" << column;
+                Q5250_TRACE(trace, byte, row, column);
+            }
+            break;
+        case WtdOrder::WriteExtendedAttribute:
+            {
+                // extended attributes are not supported yet
+                unsigned char attributeType = stream.readByte();
+                unsigned char attribute = stream.readByte();
+                Q5250_TRACE(trace, byte, attributeType, attribute);
             }
             break;
-        case 0x1d /*START OF FIELD*/:
+        case WtdOrder::InsertCursor:
+        case WtdOrder::MoveCursor:
             {
-                Field *field = new Field();
+                unsigned char row = stream.readByte();
+                unsigned char column = stream.readByte();
+                cursor.setPosition(column, row);
+                Q5250_TRACE(trace, byte, row, column);
+            }
+            break;
+        case WtdOrder::StartOfField:
+            {
+                Field field = Field();
 
-                unsigned char byte = stream.readByte();
-                if (byte & 0x40 /*is input field?*/) {
+                unsigned char ffw1 = stream.readByte();
+                if (ffw1 & 0x40 /*is input field?*/) {
                     unsigned char ffw2 = stream.readByte();
-                    field->format = (byte << 8) | ffw2;
-                    field->attribute = stream.readByte();
+                    field.format = (ffw1 << 8) | ffw2;
+                    field.attribute = stream.readByte();
                 } else {
-                    field->attribute = byte;
+                    field.attribute = ffw1;
                 }
 
-                field->length = stream.readWord();
+                field.length = stream.readWord();
 
                 // leading field attribute
-                displayBuffer->setCharacter(field->attribute);
-
-                field->startColumn = displayBuffer->bufferColumn();
-                field->startRow    = displayBuffer->bufferRow();
-
-                if (field->isInputField()) {
-                    Cursor cursor(field->startColumn, field->startRow);
-                    Field *existingField = formatTable->fieldAt(cursor, displayBuffer->size().width());
-                    if (existingField) {
-                        qDebug() << "[WTD:SF ] modify existing field";
-                        existingField->format = field->format;
-                        existingField->attribute = field->attribute;
-                        delete field;
+                displayBuffer->setCharacter(field.attribute);
+
+                field.startColumn = displayBuffer->bufferColumn();
+                field.startRow    = displayBuffer->bufferRow();
+
+                if (field.isInputField()) {
+                    Cursor cursor(field.startColumn, field.startRow);
+                    int existingFieldId = formatTable->fieldAt(cursor, displayBuffer->size().width());
+                    if (existingFieldId != FormatTable::NoField) {
+                        Field &existingField = formatTable->field(existingFieldId);
+                        existingField.format = field.format;
+                        existingField.attribute = field.attribute;
+                        if (existingField.isModified()) {
+                            formatTable->markAsModified(existingFieldId);
+                        }
                     } else {
-                        qDebug() << "[WTD:SF ] add new field";
                         // ending field attribute
-                        displayBuffer->setCharacterAt(field->length, 0x20);
+                        displayBuffer->setCharacterAt(field.length, 0x20);
                         formatTable->append(field);
                     }
                 }
 
-                qDebug() << "[WTD:SF ] format =" << hex << showbase << field->format
-                         << "attribute =" << hex << showbase << field->attribute
-                         << "length =" << dec << field->length;
+                Q5250_TRACE(trace, byte, field.format >> 8, field.attribute, field.length);
             }
             break;
-        default:
-            displayBuffer->setCharacter(byte);
+        case WtdOrder::Data:
             break;
         }
     }
 }
 
+void TerminalEmulator::writeData(const char *data, int size)
+{
+    displayBuffer->writeRun(reinterpret_cast<const unsigned char *>(data), size);
+}
+
 void TerminalEmulator::handleWriteStructuredFieldCommand(GeneralDataStream &stream)
 {
     unsigned short length = stream.readWord();
@@ -296,14 +590,14 @@ void TerminalEmulator::handleWriteStructuredFieldCommand(GeneralDataStream &stre
     unsigned char commandType = stream.readByte();
     unsigned char flags = stream.readByte();
 
-    qDebug() << "[WSF] len =" << length
-             << "class =" << hex << showbase << commandClass
-             << "type =" << hex << showbase << commandType
-             << "flags =" << bin << showbase << flags;
+    qCDebug(lcTerminal) << "[WSF] len =" << length
+                        << "class =" << hex << showbase << commandClass
+                        << "type =" << hex << showbase << commandType
+                        << "flags =" << bin << showbase << flags;
 
     // 5250 QUERY command
     if (commandClass == 0xd9 && commandType == 0x70) {
-        GeneralDataStream stream;
+        GeneralDataStream &stream = beginReply();
 
         // [ROW] [COLUMN] [AID] [Structured Field]
         stream << 0x00                          // cursor row
@@ -325,14 +619,10 @@ void TerminalEmulator::handleWriteStructuredFieldCommand(GeneralDataStream &stre
                << 0x01;                         // Workstation Type: Display
 
         QByteArray machineType = codec->fromUnicode(QStringLiteral("5251"));
-        for (int i = 0; i < machineType.size(); ++i) {
-            stream << machineType.at(i);
-        }
+        stream.append(machineType.constData(), machineType.size());
 
         QByteArray modelNumber = codec->fromUnicode(QStringLiteral("011"));
-        for (int i = 0; i < modelNumber.size(); ++i) {
-            stream << modelNumber.at(i);
-        }
+        stream.append(modelNumber.constData(), modelNumber.size());
 
         stream << 0x02                          // Keyboard ID: Standard
                << 0x00                          // Extended Keyboard ID
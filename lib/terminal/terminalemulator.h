@@ -28,16 +28,22 @@
 
 #include "q5250_global.h"
 #include <QObject>
+#include <QSize>
+#include <QTimer>
+#include <vector>
 
 #include "cursor.h"
+#include "gdsrecordframer.h"
+#include "generaldatastream.h"
+#include "protocoltrace.h"
 
-class QTextCodec;
+class QIODevice;
 
 namespace q5250 {
 
 class DisplayBuffer;
+class EbcdicCodec;
 class FormatTable;
-class GeneralDataStream;
 class TerminalDisplay;
 
 class Q5250SHARED_EXPORT TerminalEmulator : public QObject
@@ -47,9 +53,19 @@ class Q5250SHARED_EXPORT TerminalEmulator : public QObject
 public:
     explicit TerminalEmulator(QObject *parent = 0);
 
+    // selects the EBCDIC code page, returns false for an unsupported CCSID
+    bool setCcsid(int ccsid);
+    int ccsid() const;
+
     void setDisplayBuffer(DisplayBuffer *buffer);
     void setFormatTable(FormatTable *table);
     void setTerminalDisplay(TerminalDisplay *display);
+    void setTraceDevice(QIODevice *device);
+
+    // Received records are drawn at most once per frame interval, or at
+    // once when they unlock the keyboard. 0 draws after every record.
+    void setFrameInterval(int msec);
+    int frameInterval() const;
 
     Cursor cursorPosition() const;
 
@@ -63,18 +79,38 @@ signals:
 public slots:
     void dataReceived(const QByteArray &data);
     void update();
+    void redraw();
     void keyPressed(int key, const QString &text);
 
 private:
+    GeneralDataStream &beginReply();
     void handleClearUnitCommand();
     void handleWriteToDisplayCommand(GeneralDataStream &stream);
+    void writeData(const char *data, int size);
     void handleWriteStructuredFieldCommand(GeneralDataStream &stream);
+    void sendFields(unsigned char command, unsigned char aid);
+    void moveCursorToField(int fieldId);
+    unsigned char drawRow(unsigned char row, int firstColumn, int lastColumn, unsigned char attribute, bool partial);
+    void drawText(unsigned char column, unsigned char row, int start, int end);
 
     DisplayBuffer *displayBuffer;
     TerminalDisplay *terminalDisplay;
     FormatTable *formatTable;
-    QTextCodec *codec;
+    const EbcdicCodec *codec;
+    QString textRun;
+    QString textPart;
+    bool fullUpdate;
+    bool updatePending;
+    bool keyboardUnlocked;
+    QTimer frameTimer;
+    QSize displaySize;
+    Cursor drawnCursor;
+    std::vector<unsigned char> rowAttributes;
     Cursor cursor;
+    unsigned char readCommand;
+    GdsRecordFramer recordFramer;
+    GeneralDataStream replyStream;
+    ProtocolTrace trace;
 };
 
 } // namespace q5250
@@ -25,49 +25,170 @@
  */
 #include "terminalformattable.h"
 
+#include <algorithm>
+
 #include "cursor.h"
-#include "field.h"
 
 namespace q5250 {
 
+static unsigned cellPosition(unsigned char column, unsigned char row)
+{
+    return (row << 8) | column;
+}
+
 void TerminalFormatTable::clear()
 {
-    qDeleteAll(fieldList);
     fieldList.clear();
+    inputFieldIds.clear();
+    modifiedFields.clear();
+    modifiedFieldIds.clear();
+    std::fill(cellFieldIds.begin(), cellFieldIds.end(), int(NoField));
 }
 
-void TerminalFormatTable::append(Field *field)
+int TerminalFormatTable::append(const Field &field)
 {
-    fieldList.append(field);
+    const int fieldId = fieldList.size();
+    fieldList.push_back(field);
+    modifiedFields.push_back(false);
+
+    if (field.isInputField() && !field.isBypassField()) {
+        auto it = std::upper_bound(inputFieldIds.begin(), inputFieldIds.end(), fieldId,
+                                   [this](int lhs, int rhs) { return fieldPosition(lhs) < fieldPosition(rhs); });
+        inputFieldIds.insert(it, fieldId);
+    }
+
+    if (field.isModified()) {
+        markAsModified(fieldId);
+    }
+
+    if (indexedWidth > 0) {
+        indexField(fieldId);
+    }
+
+    return fieldId;
 }
 
-Field *TerminalFormatTable::fieldAt(const Cursor &cursor, int displayWidth) const
+Field &TerminalFormatTable::field(int fieldId)
 {
+    return fieldList[fieldId];
+}
+
+int TerminalFormatTable::fieldAt(const Cursor &cursor, int displayWidth) const
+{
+    if (displayWidth != indexedWidth) {
+        indexCells(displayWidth);
+    }
+
     unsigned short cursorAddress = cursor.address();
+    if (cursorAddress >= cellFieldIds.size()) {
+        return NoField;
+    }
+
+    return cellFieldIds[cursorAddress];
+}
+
+int TerminalFormatTable::nextInputField(const Cursor &cursor) const
+{
+    if (inputFieldIds.empty()) {
+        return NoField;
+    }
+
+    unsigned cursorPosition = cellPosition(cursor.column(), cursor.row());
+    auto it = std::upper_bound(inputFieldIds.begin(), inputFieldIds.end(), cursorPosition,
+                               [this](unsigned pos, int fieldId) { return pos < fieldPosition(fieldId); });
+
+    return it != inputFieldIds.end() ? *it : inputFieldIds.front();
+}
+
+int TerminalFormatTable::previousInputField(const Cursor &cursor) const
+{
+    if (inputFieldIds.empty()) {
+        return NoField;
+    }
+
+    unsigned cursorPosition = cellPosition(cursor.column(), cursor.row());
+    auto it = std::lower_bound(inputFieldIds.begin(), inputFieldIds.end(), cursorPosition,
+                               [this](int fieldId, unsigned pos) { return fieldPosition(fieldId) < pos; });
 
-    Field *resultField = 0;
-    foreach (Field *field, fieldList) {
-        unsigned startFieldAddress = field->startRow * displayWidth + field->startColumn;
-        unsigned endFieldAddress = startFieldAddress + field->length - 1;
-        if (cursorAddress >= startFieldAddress && cursorAddress <= endFieldAddress) {
-            resultField = field;
-            break;
+    return it != inputFieldIds.begin() ? *(it - 1) : inputFieldIds.back();
+}
+
+void TerminalFormatTable::markAsModified(int fieldId)
+{
+    fieldList[fieldId].markAsModified();
+
+    if (!modifiedFields[fieldId]) {
+        modifiedFields[fieldId] = true;
+        modifiedFieldIds.insert(std::upper_bound(modifiedFieldIds.begin(), modifiedFieldIds.end(), fieldId), fieldId);
+    }
+}
+
+bool TerminalFormatTable::isModified() const
+{
+    for (int fieldId : modifiedFieldIds) {
+        if (fieldList[fieldId].isModified()) {
+            return true;
         }
     }
 
-    return resultField;
+    return false;
 }
 
 bool TerminalFormatTable::isEmpty() const
 {
-    return fieldList.isEmpty();
+    return fieldList.empty();
 }
 
-void TerminalFormatTable::map(std::function<void (Field *)> func) const
+void TerminalFormatTable::map(std::function<void (const Field &)> func) const
 {
-    foreach (Field *field, fieldList) {
+    for (const Field &field : fieldList) {
         func(field);
     }
 }
 
+void TerminalFormatTable::mapModified(std::function<void (const Field &)> func) const
+{
+    // skip fields whose MDT bit was reset by a later START OF FIELD
+    for (int fieldId : modifiedFieldIds) {
+        const Field &field = fieldList[fieldId];
+        if (field.isModified()) {
+            func(field);
+        }
+    }
+}
+
+unsigned TerminalFormatTable::fieldPosition(int fieldId) const
+{
+    const Field &field = fieldList[fieldId];
+    return cellPosition(field.startColumn, field.startRow);
+}
+
+void TerminalFormatTable::indexCells(int displayWidth) const
+{
+    indexedWidth = displayWidth;
+    std::fill(cellFieldIds.begin(), cellFieldIds.end(), int(NoField));
+
+    for (int fieldId = 0; fieldId < (int)fieldList.size(); ++fieldId) {
+        indexField(fieldId);
+    }
+}
+
+void TerminalFormatTable::indexField(int fieldId) const
+{
+    const Field &field = fieldList[fieldId];
+    unsigned startFieldAddress = field.startRow * indexedWidth + field.startColumn;
+    unsigned endFieldAddress = startFieldAddress + field.length;
+
+    if (endFieldAddress > cellFieldIds.size()) {
+        cellFieldIds.resize(endFieldAddress, NoField);
+    }
+
+    // overlapping fields keep the cells of the field appended first
+    for (unsigned address = startFieldAddress; address < endFieldAddress; ++address) {
+        if (cellFieldIds[address] == NoField) {
+            cellFieldIds[address] = fieldId;
+        }
+    }
+}
+
 } // namespace q5250
@@ -28,25 +28,56 @@
 
 #include "q5250_global.h"
 #include "formattable.h"
+#include "field.h"
 
-#include <QVector>
+#include <vector>
 
 namespace q5250 {
 
+/*
+ * The fields are stored by value in one contiguous list, the field id is
+ * the index into that list. clear() keeps the capacity for the next screen.
+ *
+ * fieldAt() reads the field from an index of the display cells. The index
+ * is built for the display width of the first lookup and extended by each
+ * appended field. Input fields the cursor can enter are kept ordered by
+ * their position for the tab navigation.
+ *
+ * Modified fields are tracked in a bitset and a list of their ids, so
+ * mapModified() only visits the modified fields.
+ */
 class Q5250SHARED_EXPORT TerminalFormatTable : public FormatTable
 {
 public:
     void clear();
-    void append(Field *field);
+    int append(const Field &field);
 
-    virtual Field* fieldAt(const Cursor &cursor, int displayWidth) const;
+    Field &field(int fieldId);
+
+    int fieldAt(const Cursor &cursor, int displayWidth) const;
+    int nextInputField(const Cursor &cursor) const;
+    int previousInputField(const Cursor &cursor) const;
+
+    void markAsModified(int fieldId);
+    bool isModified() const;
 
     bool isEmpty() const;
 
-    void map(std::function<void (Field*)> func) const;
+    void map(std::function<void (const Field &)> func) const;
+    void mapModified(std::function<void (const Field &)> func) const;
 
 private:
-    QVector<Field*> fieldList;
+    unsigned fieldPosition(int fieldId) const;
+    void indexCells(int displayWidth) const;
+    void indexField(int fieldId) const;
+
+    std::vector<Field> fieldList;
+    std::vector<int> inputFieldIds;
+    std::vector<bool> modifiedFields;
+    std::vector<int> modifiedFieldIds;
+
+    mutable std::vector<int> cellFieldIds;
+    mutable int indexedWidth = 0;
 };
 
 } // namespace q5250
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef Q5250_WTDORDER_H
+#define Q5250_WTDORDER_H
+
+namespace q5250 {
+
+// Meaning of a byte in the data of a WRITE TO DISPLAY command
+enum class WtdOrder : unsigned char
+{
+    Data,
+    StartOfHeader,
+    RepeatToAddress,
+    EraseToAddress,
+    Escape,
+    TransparentData,
+    SetBufferAddress,
+    WriteExtendedAttribute,
+    InsertCursor,
+    MoveCursor,
+    StartOfField
+};
+
+constexpr WtdOrder classifyWtdByte(int byte)
+{
+    return byte == 0x01 ? WtdOrder::StartOfHeader :
+           byte == 0x02 ? WtdOrder::RepeatToAddress :
+           byte == 0x03 ? WtdOrder::EraseToAddress :
+           byte == 0x04 ? WtdOrder::Escape :
+           byte == 0x10 ? WtdOrder::TransparentData :
+           byte == 0x11 ? WtdOrder::SetBufferAddress :
+           byte == 0x12 ? WtdOrder::WriteExtendedAttribute :
+           byte == 0x13 ? WtdOrder::InsertCursor :
+           byte == 0x14 ? WtdOrder::MoveCursor :
+           byte == 0x1d ? WtdOrder::StartOfField :
+                          WtdOrder::Data;
+}
+
+struct WtdOrderTable
+{
+    WtdOrder orders[256];
+};
+
+template<int... Bytes> struct WtdByteList {};
+template<int N, int... Bytes> struct MakeWtdByteList : MakeWtdByteList<N-1, N-1, Bytes...> {};
+template<int... Bytes> struct MakeWtdByteList<0, Bytes...> { typedef WtdByteList<Bytes...> type; };
+
+template<int... Bytes>
+constexpr WtdOrderTable makeWtdOrderTable(WtdByteList<Bytes...>)
+{
+    return WtdOrderTable{ { classifyWtdByte(Bytes)... } };
+}
+
+// Generated at compile time, so that the WTD loop classifies
+// each byte with a single lookup
+constexpr WtdOrderTable WtdOrders = makeWtdOrderTable(MakeWtdByteList<256>::type());
+
+static_assert(WtdOrders.orders[0x00] == WtdOrder::Data, "null is data");
+static_assert(WtdOrders.orders[0x1d] == WtdOrder::StartOfField, "SF is an order");
+static_assert(WtdOrders.orders[0x20] == WtdOrder::Data, "attributes are data");
+static_assert(WtdOrders.orders[0xff] == WtdOrder::Data, "last entry is generated");
+
+inline WtdOrder wtdOrder(unsigned char byte)
+{
+    return WtdOrders.orders[byte];
+}
+
+} // namespace q5250
+
+#endif // Q5250_WTDORDER_H
@@ -31,6 +31,9 @@
 #include <QKeyEvent>
 #include <QMap>
 #include <QPainter>
+#include <QRegion>
+#include <QScreen>
+#include <QTextStream>
 #include <QWidget>
 
 #include <generaldatastream.h>
@@ -78,10 +81,14 @@ public:
     TerminalDisplayWidget();
 
     void clear();
+    void clearArea(unsigned char column, unsigned char row, unsigned char columns, unsigned char rows);
     void displayText(unsigned char column, unsigned char row, const QString &text);
     void displayAttribute(unsigned char attribute);
     void displayCursor(unsigned char column, unsigned char row);
 
+public slots:
+    void updateDamagedRegion();
+
 signals:
     void sizeChanged();
     void keyPressed(int key, const QString &text);
@@ -94,10 +101,12 @@ protected:
 private:
     bool showUnderline(unsigned char attribute);
     bool isNonDisplay(unsigned char attribute);
+    QRect cellRect(unsigned char column, unsigned char row, int columns, int rows) const;
 
     QPixmap *screen;
     QPainter *painter;
     unsigned char lastAttribute;
+    QRegion damagedRegion;
 };
 
 TerminalDisplayWidget::TerminalDisplayWidget() :
@@ -117,6 +126,17 @@ TerminalDisplayWidget::TerminalDisplayWidget() :
 void TerminalDisplayWidget::clear()
 {
     screen->fill(Qt::black);
+    displayAttribute(0x20);
+
+    damagedRegion = rect();
+}
+
+void TerminalDisplayWidget::clearArea(unsigned char column, unsigned char row, unsigned char columns, unsigned char rows)
+{
+    const QRect area = cellRect(column, row, columns, rows);
+    painter->fillRect(area, Qt::black);
+
+    damagedRegion += area;
 }
 
 void TerminalDisplayWidget::displayText(unsigned char column, unsigned char row, const QString &text)
@@ -134,6 +154,8 @@ void TerminalDisplayWidget::displayText(unsigned char column, unsigned char row,
     painter->setBackgroundMode(Qt::OpaqueMode);
 
     painter->drawText(x, y, text);
+
+    damagedRegion += cellRect(column, row, text.length(), 1);
 }
 
 void TerminalDisplayWidget::displayAttribute(unsigned char attribute)
@@ -166,13 +188,21 @@ void TerminalDisplayWidget::displayCursor(unsigned char column, unsigned char ro
     painter->setBrush(Qt::white);
     painter->drawRect(x, y+3, fm.width('_'), 1);
     painter->restore();
+
+    damagedRegion += cellRect(column, row, 1, 1);
+}
+
+void TerminalDisplayWidget::updateDamagedRegion()
+{
+    update(damagedRegion);
+    damagedRegion = QRegion();
 }
 
 void TerminalDisplayWidget::paintEvent(QPaintEvent *event)
 {
 //    qDebug() << Q_FUNC_INFO;
     QPainter p(this);
-    p.drawPixmap(0, 0, *screen);
+    p.drawPixmap(event->rect(), *screen, event->rect());
 }
 
 void TerminalDisplayWidget::resizeEvent(QResizeEvent *event)
@@ -213,6 +243,14 @@ bool TerminalDisplayWidget::isNonDisplay(unsigned char attribute)
     return (attribute & NON_DISPLAY_MASK) == NON_DISPLAY_MASK;
 }
 
+// text is drawn on the baseline at row * height, the cell reaches up by the ascent
+QRect TerminalDisplayWidget::cellRect(unsigned char column, unsigned char row, int columns, int rows) const
+{
+    QFontMetrics fm = painter->fontMetrics();
+    return QRect(column * fm.width('X'), row * fm.height() - fm.ascent(),
+                 columns * fm.width('X'), rows * fm.height());
+}
+
 class Main : public QObject
 {
     Q_OBJECT
@@ -237,6 +275,8 @@ Main::Main(QObject *parent) :
     terminal(new TerminalEmulator()),
     display(new TerminalDisplayWidget())
 {
+    connect(connection, &TcpSocketTelnetConnection::connected,
+            client, &TelnetClient::connected);
     connect(connection, &TcpSocketTelnetConnection::readyRead,
             client, &TelnetClient::readyRead);
 
@@ -246,18 +286,47 @@ Main::Main(QObject *parent) :
             client, &TelnetClient::sendData);
 
     connect(display, &TerminalDisplayWidget::sizeChanged,
-            terminal, &TerminalEmulator::update);
+            terminal, &TerminalEmulator::redraw);
     connect(display, &TerminalDisplayWidget::keyPressed,
             terminal, &TerminalEmulator::keyPressed);
     connect(terminal, &TerminalEmulator::updateFinished,
-            display, static_cast<void (QWidget::*)()>(&QWidget::update));
+            display, &TerminalDisplayWidget::updateDamagedRegion);
 
     client->setTerminalType("IBM-3477-FC");
+    client->setOfferOptionsOnConnect(true);
     terminal->setDisplayBuffer(new TerminalDisplayBuffer());
     terminal->setFormatTable(new TerminalFormatTable());
     terminal->setTerminalDisplay(display);
+
+    // EBCDIC code page of the host, e.g. Q5250_CCSID=1141
+    const int ccsid = qgetenv("Q5250_CCSID").toInt();
+    if (ccsid && !terminal->setCcsid(ccsid)) {
+        qWarning() << "Unsupported CCSID" << ccsid;
+    }
+
+    // coalesce bursts of host output to one update per frame, e.g. Q5250_FRAME_INTERVAL=33
+    bool hasFrameInterval = false;
+    const int frameInterval = qgetenv("Q5250_FRAME_INTERVAL").toInt(&hasFrameInterval);
+    if (hasFrameInterval) {
+        terminal->setFrameInterval(frameInterval);
+    } else if (QGuiApplication::primaryScreen()) {
+        terminal->setFrameInterval(qRound(1000 / QGuiApplication::primaryScreen()->refreshRate()));
+    }
+
     connection->connectToHost(QStringLiteral("ASKNIDEV.int.kn"), 23);
 
+    // binary order trace, see ProtocolTrace
+    const QString traceFileName = QString::fromLocal8Bit(qgetenv("Q5250_TRACE_FILE"));
+    if (!traceFileName.isEmpty()) {
+        QFile *traceFile = new QFile(traceFileName, this);
+        if (traceFile->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            terminal->setTraceDevice(traceFile);
+            connect(qApp, &QCoreApplication::aboutToQuit, [this]() {
+                terminal->setTraceDevice(nullptr);
+            });
+        }
+    }
+
     display->show();
     terminal->update();
 }
@@ -275,12 +344,13 @@ void Main::dataReceived(const QByteArray &data)
 //    qDebug() << "Valid?" << stream.isValid();
 }
 
+static QFile logFile("LogFile.log");
+static QTextStream logStream(&logFile);
+
 void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
-   Q_UNUSED(context);
-
    QString dt = QDateTime::currentDateTime().toString("dd/MM/yyyy hh:mm:ss");
-   QString txt = QString("[%1] ").arg(dt);
+   QString txt = QString("[%1] [%2] ").arg(dt).arg(context.category);
 
    switch (type)
    {
@@ -295,25 +365,27 @@ void customMessageHandler(QtMsgType type, const QMessageLogContext &context, con
          break;
       case QtFatalMsg:
          txt += QString("{Fatal} \t\t %1").arg(msg);
+         logStream << txt << endl;
          abort();
          break;
    }
 
-   QFile outFile("LogFile.log");
-   outFile.open(QIODevice::WriteOnly | QIODevice::Append);
-
-   QTextStream textStream(&outFile);
-   textStream << txt << endl;
+   logStream << txt << '\n';
 }
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
+
+    // opened once, the handler runs for every message
+    logFile.open(QIODevice::WriteOnly | QIODevice::Append);
     qInstallMessageHandler(customMessageHandler);
 
     Main main;
 
-    return app.exec();
+    int result = app.exec();
+    logStream.flush();
+    return result;
 }
 
 #include "main.moc"
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <QtTest>
+
+#include <terminal/ebcdiccodec.h>
+#include <terminal/terminaldisplaybuffer.h>
+using namespace q5250;
+
+class EbcdicCodecBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void scalarCellsToUnicode_data() { cellsData(); }
+    void scalarCellsToUnicode();
+    void vectorCellsToUnicode_data() { cellsData(); }
+    void vectorCellsToUnicode();
+    void rowToUnicode_data() { screenData(); }
+    void rowToUnicode();
+    void bufferToUnicode_data() { screenData(); }
+    void bufferToUnicode();
+
+private:
+    void cellsData();
+    void screenData();
+    void cellsToUnicode(EbcdicCodec::CellConversion conversion);
+    void fillScreen(TerminalDisplayBuffer &displayBuffer, int columns, int rows);
+};
+
+void EbcdicCodecBenchmark::cellsData()
+{
+    QTest::addColumn<int>("ccsid");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("37 80") << 37 << 80;
+    QTest::newRow("37 132") << 37 << 132;
+    QTest::newRow("37 24x80") << 37 << 24 * 80;
+    QTest::newRow("37 27x132") << 37 << 27 * 132;
+    QTest::newRow("1140 80") << 1140 << 80;
+    QTest::newRow("1140 132") << 1140 << 132;
+    QTest::newRow("1140 24x80") << 1140 << 24 * 80;
+    QTest::newRow("1140 27x132") << 1140 << 27 * 132;
+}
+
+void EbcdicCodecBenchmark::screenData()
+{
+    QTest::addColumn<int>("ccsid");
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("rows");
+
+    QTest::newRow("37 24x80") << 37 << 80 << 24;
+    QTest::newRow("37 27x132") << 37 << 132 << 27;
+    QTest::newRow("1140 24x80") << 1140 << 80 << 24;
+    QTest::newRow("1140 27x132") << 1140 << 132 << 27;
+}
+
+void EbcdicCodecBenchmark::fillScreen(TerminalDisplayBuffer &displayBuffer, int columns, int rows)
+{
+    displayBuffer.setSize(columns, rows);
+    displayBuffer.setBufferAddress(1, 1);
+    for (int i = 0; i < columns * rows; ++i) {
+        displayBuffer.setCharacter(0x40 + i % 0xbf);
+    }
+}
+
+void EbcdicCodecBenchmark::cellsToUnicode(EbcdicCodec::CellConversion conversion)
+{
+    QFETCH(int, ccsid);
+    QFETCH(int, size);
+
+    const EbcdicCodec *codec = EbcdicCodec::codecForCcsid(ccsid);
+    QByteArray cells(size, '\0');
+    for (int i = 0; i < size; ++i) {
+        cells[i] = char(0x40 + i % 0xbf);
+    }
+    QString text(size, QChar(' '));
+
+    QBENCHMARK {
+        codec->cellsToUnicode(reinterpret_cast<const unsigned char*>(cells.constData()), size, text.data(), conversion);
+    }
+
+    QCOMPARE(text.at(0), codec->toUnicode(0x40));
+}
+
+// Both paths translate through the same display table.
+void EbcdicCodecBenchmark::scalarCellsToUnicode()
+{
+    cellsToUnicode(EbcdicCodec::CellConversion::Scalar);
+}
+
+void EbcdicCodecBenchmark::vectorCellsToUnicode()
+{
+    if (!EbcdicCodec::hasVectorCellConversion()) {
+        QSKIP("no vector path on this CPU");
+    }
+
+    cellsToUnicode(EbcdicCodec::CellConversion::Vector);
+}
+
+void EbcdicCodecBenchmark::rowToUnicode()
+{
+    QFETCH(int, ccsid);
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+
+    const EbcdicCodec *codec = EbcdicCodec::codecForCcsid(ccsid);
+    TerminalDisplayBuffer displayBuffer;
+    fillScreen(displayBuffer, columns, rows);
+    QString text(columns, QChar(' '));
+
+    QBENCHMARK {
+        displayBuffer.rowToUnicode(1, codec, text.data());
+    }
+
+    QCOMPARE(text.at(0), codec->toUnicode(0x40));
+}
+
+void EbcdicCodecBenchmark::bufferToUnicode()
+{
+    QFETCH(int, ccsid);
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+
+    const EbcdicCodec *codec = EbcdicCodec::codecForCcsid(ccsid);
+    TerminalDisplayBuffer displayBuffer;
+    fillScreen(displayBuffer, columns, rows);
+    QString text(columns * rows, QChar(' '));
+
+    QBENCHMARK {
+        displayBuffer.toUnicode(codec, text.data());
+    }
+
+    QCOMPARE(text.at(0), codec->toUnicode(0x40));
+}
+
+QTEST_MAIN(EbcdicCodecBenchmark)
+#include "ebcdiccodecbenchmark.moc"
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include <generaldatastream.h>
+using namespace q5250;
+
+// Builds a full screen WRITE TO DISPLAY record with a GDS header:
+// every row is addressed and filled with field data.
+static QByteArray fullScreenRecord(int columns, int rows)
+{
+    QByteArray record;
+    record.append("\x00\x00\x12\xa0\x00\x00\x04\x00\x00\x03", 10);
+    record.append("\x04\x11\x00\x18", 4);
+
+    for (int row = 1; row <= rows; ++row) {
+        record.append('\x11').append((char)row).append('\x01');
+        record.append("\x1d\x40\x00\x24", 4);
+        record.append((char)0x00).append((char)(columns - 4));
+        for (int column = 4; column <= columns; ++column) {
+            record.append((char)(0xc1 + (row + column) % 9));
+        }
+    }
+
+    record[0] = (char)(record.size() >> 8);
+    record[1] = (char)record.size();
+    return record;
+}
+
+// The reader GeneralDataStream used before it read the record directly.
+class LegacyDataStream
+{
+public:
+    explicit LegacyDataStream(const QByteArray &data) : stream(new QDataStream(data))
+    {
+        stream->skipRawData(10);
+    }
+
+    bool atEnd() const { return stream->atEnd(); }
+    unsigned char readByte() { unsigned char byte; *stream >> byte; return byte; }
+    unsigned short readWord()
+    {
+        unsigned char highByte, lowByte;
+        *stream >> highByte >> lowByte;
+        return (highByte << 8) | lowByte;
+    }
+    void seekToPreviousByte() { stream->device()->seek(stream->device()->pos() - 1); }
+
+private:
+    QScopedPointer<QDataStream> stream;
+};
+
+// Walks the orders like the WRITE TO DISPLAY handler of the emulator.
+template<typename Stream>
+static unsigned walkOrders(const QByteArray &record)
+{
+    Stream stream(record);
+    unsigned checksum = 0;
+
+    stream.readByte();  // ESC
+    stream.readByte();  // WTD
+    checksum += stream.readByte();
+    checksum += stream.readByte();
+
+    while (!stream.atEnd()) {
+        unsigned char byte = stream.readByte();
+        switch (byte) {
+        case 0x04 /*ESC*/:
+            stream.seekToPreviousByte();
+            return checksum;
+        case 0x11 /*SET BUFFER ADDRESS*/:
+            checksum += stream.readByte();
+            checksum += stream.readByte();
+            break;
+        case 0x1d /*START OF FIELD*/:
+            if (stream.readByte() & 0x40) {
+                checksum += stream.readByte();
+            }
+            checksum += stream.readByte();
+            checksum += stream.readWord();
+            break;
+        default:
+            checksum += byte;
+            break;
+        }
+    }
+
+    return checksum;
+}
+
+class GeneralDataStreamBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void legacyRead_data() { recordData(); }
+    void legacyRead();
+    void spanRead_data() { recordData(); }
+    void spanRead();
+
+private:
+    void recordData();
+    template<typename Stream> void readRecords();
+};
+
+void GeneralDataStreamBenchmark::recordData()
+{
+    QTest::addColumn<QByteArray>("record");
+
+    QTest::newRow("24x80") << fullScreenRecord(80, 24);
+    QTest::newRow("27x132") << fullScreenRecord(132, 27);
+}
+
+template<typename Stream>
+void GeneralDataStreamBenchmark::readRecords()
+{
+    QFETCH(QByteArray, record);
+
+    QCOMPARE(walkOrders<LegacyDataStream>(record), walkOrders<GeneralDataStream>(record));
+
+    qint64 bytes = 0;
+    unsigned checksum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 500) {
+        for (int i = 0; i < 100; ++i) {
+            checksum += walkOrders<Stream>(record);
+        }
+        bytes += 100 * record.size();
+    }
+
+    // report the time per record byte
+    QVERIFY(checksum != 0);
+    QTest::setBenchmarkResult(timer.nsecsElapsed() / qreal(bytes), QTest::WalltimeNanoseconds);
+}
+
+void GeneralDataStreamBenchmark::legacyRead()
+{
+    readRecords<LegacyDataStream>();
+}
+
+void GeneralDataStreamBenchmark::spanRead()
+{
+    readRecords<GeneralDataStream>();
+}
+
+QTEST_MAIN(GeneralDataStreamBenchmark)
+#include "generaldatastreambenchmark.moc"
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QtTest>
+
+#include <arpa/inet.h>
+#include <linux/perf_event.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <telnet/epollreactor.h>
+#include <telnet/nativetelnetconnection.h>
+#include <telnet/tcpsockettelnetconnection.h>
+#ifdef Q5250_WITH_IO_URING
+#include <telnet/iouringreactor.h>
+#endif
+using namespace q5250;
+
+static const int Sessions = 500;
+static const int ScreensPerSession = 50;
+static const int ScreenSize = 2000;
+
+// Sends full screen sized records to all sessions from its own
+// thread, so only the client side is measured.
+class ScreenServer
+{
+public:
+    ScreenServer() : listenFd(::socket(AF_INET, SOCK_STREAM, 0)), listenPort(0)
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t length = sizeof(address);
+        ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), length);
+        ::listen(listenFd, SOMAXCONN);
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        listenPort = ntohs(address.sin_port);
+
+        thread = std::thread([this]() { serve(); });
+    }
+    ~ScreenServer()
+    {
+        thread.join();
+        for (int fd : clientFds) {
+            ::close(fd);
+        }
+        ::close(listenFd);
+    }
+
+    quint16 port() const { return listenPort; }
+
+private:
+    void serve()
+    {
+        for (int i = 0; i < Sessions; ++i) {
+            clientFds.push_back(::accept(listenFd, nullptr, nullptr));
+        }
+
+        const QByteArray screen(ScreenSize, 'A');
+        for (int i = 0; i < ScreensPerSession; ++i) {
+            for (int fd : clientFds) {
+                ::send(fd, screen.constData(), screen.size(), 0);
+            }
+        }
+    }
+
+    int listenFd;
+    quint16 listenPort;
+    std::vector<int> clientFds;
+    std::thread thread;
+};
+
+// Counts the system calls of the calling thread, needs access
+// to the raw_syscalls tracepoint (perf_event_paranoid).
+class SyscallCounter
+{
+public:
+    SyscallCounter() : fd(-1)
+    {
+        QFile idFile("/sys/kernel/tracing/events/raw_syscalls/sys_enter/id");
+        if (!idFile.open(QIODevice::ReadOnly)) {
+            idFile.setFileName("/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id");
+            if (!idFile.open(QIODevice::ReadOnly)) return;
+        }
+
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = idFile.readAll().trimmed().toULongLong();
+
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~SyscallCounter() { if (fd >= 0) ::close(fd); }
+
+    bool isValid() const { return fd >= 0; }
+    qint64 count() const
+    {
+        qint64 value = 0;
+        if (fd >= 0 && ::read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+        return value;
+    }
+
+private:
+    int fd;
+};
+
+static qint64 threadCpuTimeMicroseconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL
+         + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+class TelnetConnectionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void receiveScreens_data();
+    void receiveScreens();
+
+private:
+    qint64 receiveWithTcpSocket(quint16 port);
+    qint64 receiveWithReactor(TelnetReactor &reactor, quint16 port);
+};
+
+void TelnetConnectionBenchmark::receiveScreens_data()
+{
+    QTest::addColumn<QString>("transport");
+
+    QTest::newRow("QTcpSocket") << "QTcpSocket";
+    QTest::newRow("epoll") << "epoll";
+#ifdef Q5250_WITH_IO_URING
+    QTest::newRow("io_uring") << "io_uring";
+#endif
+}
+
+void TelnetConnectionBenchmark::receiveScreens()
+{
+    QFETCH(QString, transport);
+
+    ScreenServer server;
+    SyscallCounter syscalls;
+    const qint64 syscallsBefore = syscalls.count();
+    const qint64 cpuTimeBefore = threadCpuTimeMicroseconds();
+
+    qint64 bytes = 0;
+    if (transport == "QTcpSocket") {
+        bytes = receiveWithTcpSocket(server.port());
+    } else if (transport == "epoll") {
+        EpollReactor reactor;
+        bytes = receiveWithReactor(reactor, server.port());
+    }
+#ifdef Q5250_WITH_IO_URING
+    else if (transport == "io_uring") {
+        IoUringReactor reactor;
+        if (!reactor.isValid()) {
+            QSKIP("io_uring is not supported by the kernel");
+        }
+        bytes = receiveWithReactor(reactor, server.port());
+    }
+#endif
+
+    const qint64 cpuTime = threadCpuTimeMicroseconds() - cpuTimeBefore;
+    const qreal kilobytes = bytes / 1024.0;
+    QCOMPARE(bytes, qint64(Sessions) * ScreensPerSession * ScreenSize);
+
+    qDebug("%s: %.1f us CPU per session, %.2f us CPU per KB",
+           qPrintable(transport), qreal(cpuTime) / Sessions, cpuTime / kilobytes);
+
+    if (syscalls.isValid()) {
+        const qreal syscallsPerKilobyte = (syscalls.count() - syscallsBefore) / kilobytes;
+        QTest::setBenchmarkResult(syscallsPerKilobyte, QTest::Events);
+    } else {
+        qDebug("system calls not counted, raw_syscalls tracepoint is not accessible");
+    }
+}
+
+qint64 TelnetConnectionBenchmark::receiveWithTcpSocket(quint16 port)
+{
+    QList<TcpSocketTelnetConnection*> connections;
+    qint64 bytes = 0;
+    const qint64 expectedBytes = qint64(Sessions) * ScreensPerSession * ScreenSize;
+
+    for (int i = 0; i < Sessions; ++i) {
+        TcpSocketTelnetConnection *connection = new TcpSocketTelnetConnection(this);
+        connect(connection, &TcpSocketTelnetConnection::readyRead, [&bytes, connection]() {
+            bytes += connection->readAll().size();
+        });
+        connection->connectToHost("127.0.0.1", port);
+        connections.append(connection);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (bytes < expectedBytes && timer.elapsed() < 60000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    qDeleteAll(connections);
+    return bytes;
+}
+
+qint64 TelnetConnectionBenchmark::receiveWithReactor(TelnetReactor &reactor, quint16 port)
+{
+    std::vector<std::unique_ptr<NativeTelnetConnection>> connections;
+    qint64 bytes = 0;
+    const qint64 expectedBytes = qint64(Sessions) * ScreensPerSession * ScreenSize;
+
+    for (int i = 0; i < Sessions; ++i) {
+        std::unique_ptr<NativeTelnetConnection> connection = reactor.createConnection();
+        NativeTelnetConnection *session = connection.get();
+        session->setReadyReadHandler([&bytes, session]() {
+            char buffer[4096];
+            qint64 bytesRead;
+            do {
+                bytesRead = session->read(buffer, sizeof(buffer));
+                bytes += qMax(bytesRead, qint64(0));
+            } while (bytesRead == sizeof(buffer));
+        });
+        session->connectToHost("127.0.0.1", port);
+        connections.push_back(std::move(connection));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (bytes < expectedBytes && timer.elapsed() < 60000) {
+        reactor.processEvents(100);
+    }
+
+    return bytes;
+}
+
+QTEST_MAIN(TelnetConnectionBenchmark)
+#include "telnetconnectionbenchmark.moc"
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QtTest>
+
+#include <telnet/telnetparser.h>
+#include <telnet/telnetreceivebuffer.h>
+using namespace q5250;
+
+static const char IAC = '\xff';
+static const char EOR = '\xef';
+
+// Builds a capture of full screen WRITE TO DISPLAY records like the
+// host sends them: every row is addressed and filled with field data.
+static QByteArray fullScreenCapture(int columns, int rows, int records)
+{
+    QByteArray record;
+    record.append("\x00\x00\x12\xa0\x00\x00\x04\x00\x00\x03", 10);
+    record.append("\x04\x11\x00\x18", 4);
+
+    for (int row = 1; row <= rows; ++row) {
+        record.append('\x11').append((char)row).append('\x01');
+        record.append("\x1d\x40\x00\x24", 4);
+        for (int column = 4; column <= columns; ++column) {
+            record.append((char)(0xc1 + (row + column) % 9));
+        }
+    }
+
+    // a single escaped 0xff data byte per record
+    record.append(IAC).append(IAC);
+    record.append(IAC).append(EOR);
+
+    QByteArray capture;
+    for (int i = 0; i < records; ++i) {
+        capture.append(record);
+    }
+    return capture;
+}
+
+// The algorithm the parser used before it became a streaming scanner.
+static int legacyParse(const QByteArray &data)
+{
+    QByteArray unescaped(data);
+    unescaped.replace("\xff\xff", "\xff");
+
+    QList<QByteArray> records;
+    int from = 0;
+    int to = unescaped.indexOf("\xff\xef", from);
+    while (to >= 0) {
+        records.append(unescaped.mid(from, to - from));
+        from = to + 2;
+        to = unescaped.indexOf("\xff\xef", from);
+    }
+
+    return records.size();
+}
+
+class TelnetParserBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void legacyParse_data() { captureData(); }
+    void legacyParse();
+    void streamingParse_data() { captureData(); }
+    void streamingParse();
+
+private:
+    void captureData();
+    void reportBytesPerSecond(qint64 bytes, const QElapsedTimer &timer);
+};
+
+void TelnetParserBenchmark::captureData()
+{
+    QTest::addColumn<QByteArray>("capture");
+
+    QTest::newRow("24x80") << fullScreenCapture(80, 24, 256);
+    QTest::newRow("27x132") << fullScreenCapture(132, 27, 256);
+}
+
+void TelnetParserBenchmark::reportBytesPerSecond(qint64 bytes, const QElapsedTimer &timer)
+{
+    qreal seconds = timer.nsecsElapsed() / 1e9;
+    QTest::setBenchmarkResult(bytes / seconds, QTest::BytesPerSecond);
+}
+
+void TelnetParserBenchmark::legacyParse()
+{
+    QFETCH(QByteArray, capture);
+
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 500) {
+        QVERIFY(::legacyParse(capture) > 0);
+        bytes += capture.size();
+    }
+
+    reportBytesPerSecond(bytes, timer);
+}
+
+void TelnetParserBenchmark::streamingParse()
+{
+    QFETCH(QByteArray, capture);
+
+    TelnetParser parser;
+    TelnetReceiveBuffer buffer;
+    int records = 0;
+    connect(&parser, &TelnetParser::dataReceived, [&](const QByteArray &) { ++records; });
+
+    // feed the capture in TCP segment sized chunks
+    static const int SegmentSize = 1460;
+
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 500) {
+        for (int i = 0; i < capture.size(); i += SegmentSize) {
+            buffer.append(capture.constData() + i, qMin(SegmentSize, capture.size() - i));
+            parser.parse(buffer);
+        }
+        bytes += capture.size();
+    }
+
+    QVERIFY(records > 0);
+    reportBytesPerSecond(bytes, timer);
+}
+
+QTEST_MAIN(TelnetParserBenchmark)
+#include "telnetparserbenchmark.moc"
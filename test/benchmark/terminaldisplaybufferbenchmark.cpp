@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <QtTest>
+
+#include <terminal/terminaldisplaybuffer.h>
+using namespace q5250;
+
+// The per cell loop repeatCharacterToAddress() used before it filled spans.
+static void repeatCharacterPerCell(TerminalDisplayBuffer &displayBuffer, unsigned char column, unsigned char row,
+                                   unsigned char character)
+{
+    const int width = displayBuffer.size().width();
+    const int fromAddress = (displayBuffer.bufferRow()-1) * width + (displayBuffer.bufferColumn()-1);
+    const int toAddress = (row-1) * width + (column-1);
+
+    for (int i = fromAddress; i <= toAddress; ++i) {
+        displayBuffer.setCharacter(character);
+    }
+}
+
+class TerminalDisplayBufferBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void perCellRepeat_data() { screenData(); }
+    void perCellRepeat();
+    void spanRepeat_data() { screenData(); }
+    void spanRepeat();
+
+private:
+    void screenData();
+};
+
+void TerminalDisplayBufferBenchmark::screenData()
+{
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("rows");
+
+    QTest::newRow("24x80") << 80 << 24;
+    QTest::newRow("27x132") << 132 << 27;
+}
+
+void TerminalDisplayBufferBenchmark::perCellRepeat()
+{
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+
+    TerminalDisplayBuffer displayBuffer;
+    displayBuffer.setSize(columns, rows);
+
+    QBENCHMARK {
+        displayBuffer.setBufferAddress(1, 1);
+        repeatCharacterPerCell(displayBuffer, columns, rows, 0x40);
+    }
+
+    QCOMPARE(displayBuffer.characterAt(columns, rows), (unsigned char)0x40);
+}
+
+void TerminalDisplayBufferBenchmark::spanRepeat()
+{
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+
+    TerminalDisplayBuffer displayBuffer;
+    displayBuffer.setSize(columns, rows);
+
+    QBENCHMARK {
+        displayBuffer.setBufferAddress(1, 1);
+        displayBuffer.repeatCharacterToAddress(columns, rows, 0x40);
+    }
+
+    QCOMPARE(displayBuffer.characterAt(columns, rows), (unsigned char)0x40);
+}
+
+QTEST_MAIN(TerminalDisplayBufferBenchmark)
+#include "terminaldisplaybufferbenchmark.moc"
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <sys/socket.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QSignalSpy>
+
+#include <telnet/epollreactor.h>
+#include <telnet/epolltelnetconnection.h>
+#include <telnet/telnetclient.h>
+using namespace q5250;
+
+#include "loopbackserver.h"
+
+class AnEpollTelnetConnection : public Test
+{
+public:
+    bool processEventsUntil(std::function<bool ()> condition)
+    {
+        for (int i = 0; i < 100 && !condition(); ++i) {
+            reactor.processEvents(50);
+        }
+        return condition();
+    }
+
+    bool openConnection(EpollTelnetConnection &connection)
+    {
+        connection.connectToHost("127.0.0.1", server.port);
+        clientFd = server.acceptClient();
+        return processEventsUntil([&]() { return connection.isConnected(); });
+    }
+
+    EpollReactor reactor;
+    LoopbackServer server;
+    int clientFd = -1;
+    QByteArray ArbitraryRawData{"A"};
+};
+
+TEST_F(AnEpollTelnetConnection, opensConnectionToAServer)
+{
+    EpollTelnetConnection connection(reactor);
+    bool connected = false;
+    connection.setConnectedHandler([&]() { connected = true; });
+
+    connection.connectToHost("127.0.0.1", server.port);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return connected; }));
+}
+
+TEST_F(AnEpollTelnetConnection, callsReadyReadHandlerWhenReceivingDataFromServer)
+{
+    EpollTelnetConnection connection(reactor);
+    bool readyRead = false;
+    connection.setReadyReadHandler([&]() { readyRead = true; connection.readAll(); });
+    openConnection(connection);
+
+    server.sendDataToClient(clientFd, ArbitraryRawData);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return readyRead; }));
+}
+
+TEST_F(AnEpollTelnetConnection, readsDataReceivedFromServerIntoPassedBuffer)
+{
+    EpollTelnetConnection connection(reactor);
+    QByteArray receivedData;
+    connection.setReadyReadHandler([&]() {
+        char buffer[16];
+        qint64 bytesRead = connection.read(buffer, sizeof(buffer));
+        if (bytesRead > 0) receivedData.append(buffer, bytesRead);
+    });
+    openConnection(connection);
+
+    server.sendDataToClient(clientFd, ArbitraryRawData);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return !receivedData.isEmpty(); }));
+    ASSERT_THAT(receivedData, Eq(ArbitraryRawData));
+}
+
+TEST_F(AnEpollTelnetConnection, sendsDataToServer)
+{
+    EpollTelnetConnection connection(reactor);
+    openConnection(connection);
+
+    connection.write(ArbitraryRawData);
+
+    ASSERT_THAT(server.receiveDataFromClient(clientFd, ArbitraryRawData.size()), Eq(ArbitraryRawData));
+}
+
+TEST_F(AnEpollTelnetConnection, queuesCopyOfDataThatCannotBeSentWhenSendBufferIsFull)
+{
+    const int recordCount = 8192;
+    const int recordSize = 1024;
+    EpollTelnetConnection connection(reactor);
+    openConnection(connection);
+
+    // like TelnetClient::flush() write views of one reused buffer
+    // until the server's receive and the client's send buffer are full
+    QByteArray expectedData;
+    QByteArray record(recordSize, '\0');
+    for (int i = 0; i < recordCount; ++i) {
+        record.fill(char('a' + i % 26));
+        connection.write(QByteArray::fromRawData(record.constData(), record.size()));
+        expectedData.append(record);
+    }
+    record.fill('-');
+
+    QByteArray receivedData;
+    QByteArray buffer(64 * 1024, '\0');
+    for (int i = 0; i < 10000 && receivedData.size() < expectedData.size(); ++i) {
+        reactor.processEvents(0);
+        ssize_t bytesRead = ::recv(clientFd, buffer.data(), buffer.size(), MSG_DONTWAIT);
+        if (bytesRead > 0) receivedData.append(buffer.constData(), bytesRead);
+    }
+
+    ASSERT_THAT(receivedData.size(), Eq(expectedData.size()));
+    ASSERT_TRUE(receivedData == expectedData);
+}
+
+TEST_F(AnEpollTelnetConnection, sendsDataWrittenWhileConnectingOnceConnected)
+{
+    EpollTelnetConnection connection(reactor);
+    connection.connectToHost("127.0.0.1", server.port);
+    connection.write(ArbitraryRawData);
+    clientFd = server.acceptClient();
+
+    processEventsUntil([&]() { return connection.isConnected(); });
+
+    ASSERT_THAT(server.receiveDataFromClient(clientFd, ArbitraryRawData.size()), Eq(ArbitraryRawData));
+}
+
+TEST_F(AnEpollTelnetConnection, closesConnectionWhenServerHangsUp)
+{
+    EpollTelnetConnection connection(reactor);
+    connection.setReadyReadHandler([&]() { connection.readAll(); });
+    openConnection(connection);
+
+    ::shutdown(clientFd, SHUT_RDWR);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return !connection.isConnected(); }));
+}
+
+TEST_F(AnEpollTelnetConnection, drivesManyConnectionsFromOneReactor)
+{
+    const int connectionCount = 200;
+    std::vector<std::unique_ptr<EpollTelnetConnection>> connections;
+    std::vector<int> serverFds;
+    int receivedCount = 0;
+
+    for (int i = 0; i < connectionCount; ++i) {
+        EpollTelnetConnection *connection = new EpollTelnetConnection(reactor);
+        connection->setReadyReadHandler([connection, &receivedCount]() {
+            if (!connection->readAll().isEmpty()) ++receivedCount;
+        });
+        connection->connectToHost("127.0.0.1", server.port);
+        serverFds.push_back(server.acceptClient());
+        connections.emplace_back(connection);
+    }
+    for (int fd : serverFds) {
+        server.sendDataToClient(fd, ArbitraryRawData);
+    }
+
+    ASSERT_TRUE(processEventsUntil([&]() { return receivedCount == connectionCount; }));
+}
+
+TEST_F(AnEpollTelnetConnection, deliversRecordsToTelnetClient)
+{
+    EpollTelnetConnection connection(reactor);
+    TelnetClient client(&connection);
+    QSignalSpy spy(&client, SIGNAL(dataReceived(QByteArray)));
+    connection.setReadyReadHandler([&]() { client.readyRead(); });
+    openConnection(connection);
+
+    server.sendDataToClient(clientFd, ArbitraryRawData + "\xff\xef");
+
+    ASSERT_TRUE(processEventsUntil([&]() { return spy.count() > 0; }));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(ArbitraryRawData));
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <sys/socket.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QSignalSpy>
+
+#include <telnet/iouringreactor.h>
+#include <telnet/iouringtelnetconnection.h>
+#include <telnet/telnetclient.h>
+using namespace q5250;
+
+#include "loopbackserver.h"
+
+// The tests pass trivially on kernels without io_uring support.
+class AnIoUringTelnetConnection : public Test
+{
+public:
+    bool processEventsUntil(std::function<bool ()> condition)
+    {
+        for (int i = 0; i < 100 && !condition(); ++i) {
+            reactor.processEvents(50);
+        }
+        return condition();
+    }
+
+    bool openConnection(IoUringTelnetConnection &connection)
+    {
+        connection.connectToHost("127.0.0.1", server.port);
+        clientFd = server.acceptClient();
+        return processEventsUntil([&]() { return connection.isConnected(); });
+    }
+
+    IoUringReactor reactor;
+    LoopbackServer server;
+    int clientFd = -1;
+    QByteArray ArbitraryRawData{"A"};
+};
+
+TEST_F(AnIoUringTelnetConnection, opensConnectionToAServer)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    bool connected = false;
+    connection.setConnectedHandler([&]() { connected = true; });
+
+    connection.connectToHost("127.0.0.1", server.port);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return connected; }));
+}
+
+TEST_F(AnIoUringTelnetConnection, readsDataReceivedFromServerIntoPassedBuffer)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    QByteArray receivedData;
+    connection.setReadyReadHandler([&]() {
+        char buffer[16];
+        qint64 bytesRead = connection.read(buffer, sizeof(buffer));
+        if (bytesRead > 0) receivedData.append(buffer, bytesRead);
+    });
+    openConnection(connection);
+
+    server.sendDataToClient(clientFd, ArbitraryRawData);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return !receivedData.isEmpty(); }));
+    ASSERT_THAT(receivedData, Eq(ArbitraryRawData));
+}
+
+TEST_F(AnIoUringTelnetConnection, readsDataLargerThanOneBuffer)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    QByteArray receivedData;
+    connection.setReadyReadHandler([&]() { receivedData.append(connection.readAll()); });
+    openConnection(connection);
+    const QByteArray data(20000, 'A');
+
+    server.sendDataToClient(clientFd, data);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return receivedData.size() == data.size(); }));
+}
+
+TEST_F(AnIoUringTelnetConnection, sendsDataToServer)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    openConnection(connection);
+
+    connection.write(ArbitraryRawData);
+    reactor.processEvents(0);
+
+    ASSERT_THAT(server.receiveDataFromClient(clientFd, ArbitraryRawData.size()), Eq(ArbitraryRawData));
+}
+
+TEST_F(AnIoUringTelnetConnection, sendsDataWrittenWhileConnectingOnceConnected)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    connection.connectToHost("127.0.0.1", server.port);
+    connection.write(ArbitraryRawData);
+    clientFd = server.acceptClient();
+
+    processEventsUntil([&]() { return connection.isConnected(); });
+    reactor.processEvents(0);
+
+    ASSERT_THAT(server.receiveDataFromClient(clientFd, ArbitraryRawData.size()), Eq(ArbitraryRawData));
+}
+
+TEST_F(AnIoUringTelnetConnection, closesConnectionWhenServerHangsUp)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    connection.setReadyReadHandler([&]() { connection.readAll(); });
+    openConnection(connection);
+
+    ::shutdown(clientFd, SHUT_RDWR);
+
+    ASSERT_TRUE(processEventsUntil([&]() { return !connection.isConnected(); }));
+}
+
+TEST_F(AnIoUringTelnetConnection, dropsCompletionsOfDestroyedConnection)
+{
+    if (!reactor.isValid()) return;
+    std::unique_ptr<IoUringTelnetConnection> connection(new IoUringTelnetConnection(reactor));
+    openConnection(*connection);
+    server.sendDataToClient(clientFd, ArbitraryRawData);
+
+    connection.reset();
+
+    ASSERT_THAT(reactor.processEvents(50), Ge(0));
+}
+
+TEST_F(AnIoUringTelnetConnection, drivesManyConnectionsFromOneReactor)
+{
+    if (!reactor.isValid()) return;
+    const int connectionCount = 200;
+    std::vector<std::unique_ptr<IoUringTelnetConnection>> connections;
+    std::vector<int> serverFds;
+    int receivedCount = 0;
+
+    for (int i = 0; i < connectionCount; ++i) {
+        IoUringTelnetConnection *connection = new IoUringTelnetConnection(reactor);
+        connection->setReadyReadHandler([connection, &receivedCount]() {
+            if (!connection->readAll().isEmpty()) ++receivedCount;
+        });
+        connection->connectToHost("127.0.0.1", server.port);
+        serverFds.push_back(server.acceptClient());
+        connections.emplace_back(connection);
+    }
+    processEventsUntil([&]() { return connections.back()->isConnected(); });
+    for (int fd : serverFds) {
+        server.sendDataToClient(fd, ArbitraryRawData);
+    }
+
+    ASSERT_TRUE(processEventsUntil([&]() { return receivedCount == connectionCount; }));
+}
+
+TEST_F(AnIoUringTelnetConnection, deliversRecordsToTelnetClient)
+{
+    if (!reactor.isValid()) return;
+    IoUringTelnetConnection connection(reactor);
+    TelnetClient client(&connection);
+    QSignalSpy spy(&client, SIGNAL(dataReceived(QByteArray)));
+    connection.setReadyReadHandler([&]() { client.readyRead(); });
+    openConnection(connection);
+
+    server.sendDataToClient(clientFd, ArbitraryRawData + "\xff\xef");
+
+    ASSERT_TRUE(processEventsUntil([&]() { return spy.count() > 0; }));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(ArbitraryRawData));
+}
+
+TEST(ATelnetReactor, createsWorkingConnections)
+{
+    std::unique_ptr<TelnetReactor> reactor = TelnetReactor::create();
+    LoopbackServer server;
+    std::unique_ptr<NativeTelnetConnection> connection = reactor->createConnection();
+
+    connection->connectToHost("127.0.0.1", server.port);
+    server.acceptClient();
+    for (int i = 0; i < 100 && !connection->isConnected(); ++i) {
+        reactor->processEvents(50);
+    }
+
+    ASSERT_TRUE(connection->isConnected());
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef LOOPBACKSERVER_H
+#define LOOPBACKSERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <QByteArray>
+
+// Blocking TCP server on a free loopback port for testing
+// the native telnet connections.
+class LoopbackServer
+{
+public:
+    LoopbackServer() : listenFd(::socket(AF_INET, SOCK_STREAM, 0)), port(0)
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t length = sizeof(address);
+        ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), length);
+        ::listen(listenFd, SOMAXCONN);
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+    }
+    ~LoopbackServer()
+    {
+        for (int fd : clientFds) {
+            ::close(fd);
+        }
+        ::close(listenFd);
+    }
+
+    int acceptClient()
+    {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        clientFds.push_back(fd);
+        return fd;
+    }
+
+    void sendDataToClient(int fd, const QByteArray &data) { ::send(fd, data.constData(), data.size(), 0); }
+
+    QByteArray receiveDataFromClient(int fd, int size)
+    {
+        QByteArray data(size, '\0');
+        int received = 0;
+        while (received < size) {
+            ssize_t bytesRead = ::recv(fd, data.data() + received, size - received, 0);
+            if (bytesRead <= 0) break;
+            received += bytesRead;
+        }
+        return data.left(received);
+    }
+
+    int listenFd;
+    quint16 port;
+    std::vector<int> clientFds;
+};
+
+#endif // LOOPBACKSERVER_H
@@ -125,6 +125,20 @@ TEST_F(ATcpSocketTelnetConnection, readsAllDataReceivedFromServer)
     ASSERT_THAT(receivedData, Eq(ArbitraryRawData));
 }
 
+TEST_F(ATcpSocketTelnetConnection, readsDataReceivedFromServerIntoPassedBuffer)
+{
+    TcpSocketTelnetConnection connection;
+    openConnection(connection);
+    QSignalSpy spy(&connection, SIGNAL(readyRead()));
+    server.sendDataToClient(ArbitraryRawData);
+    spy.wait();
+    char buffer[16];
+
+    qint64 bytesRead = connection.read(buffer, sizeof(buffer));
+
+    ASSERT_THAT(QByteArray(buffer, bytesRead), Eq(ArbitraryRawData));
+}
+
 TEST_F(ATcpSocketTelnetConnection, sendsDataToServer)
 {
     TcpSocketTelnetConnection connection;
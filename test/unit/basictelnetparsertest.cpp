@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QByteArray>
+#include <QList>
+
+#include <telnet/basictelnetparser.h>
+#include <telnet/telnetreceivebuffer.h>
+using namespace q5250;
+
+class RecordingHandler
+{
+public:
+    void dataReceived(const QByteArray &data)
+    {
+        // records are views into the receive buffer
+        records.append(QByteArray(data.constData(), data.size()));
+    }
+
+    void optionNegotiationReceived(TelnetCommand command, TelnetOption option)
+    {
+        optionNegotiations.append(qMakePair(command, option));
+    }
+
+    void subnegotiationReceived(TelnetOption option, SubnegotiationCommand command, const QByteArray &parameters)
+    {
+        Q_UNUSED(command);
+        subnegotiationOptions.append(option);
+        subnegotiationParameters.append(parameters);
+    }
+
+    QList<QByteArray> records;
+    QList<QPair<TelnetCommand, TelnetOption>> optionNegotiations;
+    QList<TelnetOption> subnegotiationOptions;
+    QList<QByteArray> subnegotiationParameters;
+};
+
+class ABasicTelnetParser : public Test
+{
+public:
+    ABasicTelnetParser() : parser(handler) {}
+
+    void parse(const QByteArray &data)
+    {
+        buffer.append(data.constData(), data.size());
+        parser.parse(buffer);
+    }
+
+    RecordingHandler handler;
+    TelnetReceiveBuffer buffer;
+    BasicTelnetParser<RecordingHandler> parser;
+
+    QByteArray EndOfRecordCommand{"\xff\xef"};
+    static const char IAC = '\xff';
+};
+
+TEST_F(ABasicTelnetParser, callsDataReceivedForCompleteRecord)
+{
+    parse(QByteArray("ABC") + EndOfRecordCommand);
+
+    ASSERT_THAT(handler.records.size(), Eq(1));
+    ASSERT_THAT(handler.records.at(0), Eq(QByteArray("ABC")));
+}
+
+TEST_F(ABasicTelnetParser, doesNotCallDataReceivedForIncompleteRecord)
+{
+    parse(QByteArray("ABC"));
+
+    ASSERT_TRUE(handler.records.isEmpty());
+}
+
+TEST_F(ABasicTelnetParser, unescapesIACBytesInsideOfLongDataRun)
+{
+    const QByteArray run(100, 'A');
+    const QByteArray expectedData = run + IAC + run;
+
+    parse(run + IAC + IAC + run + EndOfRecordCommand);
+
+    ASSERT_THAT(handler.records.size(), Eq(1));
+    ASSERT_THAT(handler.records.at(0), Eq(expectedData));
+}
+
+TEST_F(ABasicTelnetParser, reassemblesRecordFromSingleByteChunks)
+{
+    const QByteArray data = QByteArray("AB") + IAC + IAC + "C" + EndOfRecordCommand;
+
+    for (int i = 0; i < data.size(); ++i) {
+        parse(data.mid(i, 1));
+    }
+
+    ASSERT_THAT(handler.records.size(), Eq(1));
+    ASSERT_THAT(handler.records.at(0), Eq(QByteArray("AB\xff" "C")));
+}
+
+TEST_F(ABasicTelnetParser, callsOptionNegotiationReceivedForOptionCommand)
+{
+    const char data[]{IAC, (char)TelnetCommand::DO, (char)TelnetOption::END_OF_RECORD};
+
+    parse(QByteArray(data, 3));
+
+    ASSERT_THAT(handler.optionNegotiations.size(), Eq(1));
+    ASSERT_THAT(handler.optionNegotiations.at(0).first, Eq(TelnetCommand::DO));
+    ASSERT_THAT(handler.optionNegotiations.at(0).second, Eq(TelnetOption::END_OF_RECORD));
+}
+
+TEST_F(ABasicTelnetParser, callsSubnegotiationReceivedWithUnescapedParameters)
+{
+    const char data[]{IAC, (char)TelnetCommand::SB, (char)TelnetOption::NEW_ENVIRON, (char)SubnegotiationCommand::SEND,
+                      'A', IAC, IAC, IAC, (char)TelnetCommand::SE};
+
+    parse(QByteArray(data, 9));
+
+    ASSERT_THAT(handler.subnegotiationOptions.size(), Eq(1));
+    ASSERT_THAT(handler.subnegotiationOptions.at(0), Eq(TelnetOption::NEW_ENVIRON));
+    ASSERT_THAT(handler.subnegotiationParameters.at(0), Eq(QByteArray("A\xff")));
+}
+
+TEST_F(ABasicTelnetParser, removesCommandsFromMiddleOfRecord)
+{
+    const char nop[]{IAC, (char)TelnetCommand::NOP};
+
+    parse(QByteArray("AB") + QByteArray(nop, 2) + "CD" + EndOfRecordCommand + "E" + EndOfRecordCommand);
+
+    ASSERT_THAT(handler.records.size(), Eq(2));
+    ASSERT_THAT(handler.records.at(0), Eq(QByteArray("ABCD")));
+    ASSERT_THAT(handler.records.at(1), Eq(QByteArray("E")));
+}
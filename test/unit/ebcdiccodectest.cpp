@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <vector>
+
+#include <terminal/ebcdiccodec.h>
+using namespace q5250;
+
+class AnEbcdicCodec : public Test
+{
+public:
+    const EbcdicCodec *codec = EbcdicCodec::codecForCcsid(500);
+
+    static const unsigned char EbcdicQuestionMark = 0x6f;
+};
+
+TEST_F(AnEbcdicCodec, isNullForUnsupportedCcsid)
+{
+    ASSERT_THAT(EbcdicCodec::codecForCcsid(1047), IsNull());
+}
+
+TEST_F(AnEbcdicCodec, hasRequestedCcsid)
+{
+    ASSERT_THAT(codec->ccsid(), Eq(500));
+}
+
+TEST_F(AnEbcdicCodec, translatesCharacterToUnicode)
+{
+    ASSERT_THAT(codec->toUnicode(0xc1).unicode(), Eq('A'));
+}
+
+TEST_F(AnEbcdicCodec, translatesCharacterFromUnicode)
+{
+    ASSERT_THAT(codec->fromUnicode(QChar('A')), Eq(0xc1));
+}
+
+TEST_F(AnEbcdicCodec, translatesVariantCharactersOfCcsid)
+{
+    const EbcdicCodec *ccsid37 = EbcdicCodec::codecForCcsid(37);
+
+    ASSERT_THAT(codec->toUnicode(0x4a).unicode(), Eq('['));
+    ASSERT_THAT(ccsid37->toUnicode(0x4a).unicode(), Eq(0x00a2));
+    ASSERT_THAT(ccsid37->fromUnicode(QChar('[')), Eq(0xba));
+}
+
+TEST_F(AnEbcdicCodec, translatesEuroSignOfEuroCcsid)
+{
+    const EbcdicCodec *ccsid1140 = EbcdicCodec::codecForCcsid(1140);
+
+    ASSERT_THAT(ccsid1140->toUnicode(0x9f).unicode(), Eq(0x20ac));
+    ASSERT_THAT(ccsid1140->fromUnicode(QChar(0x20ac)), Eq(0x9f));
+}
+
+TEST_F(AnEbcdicCodec, translatesCharacterWithoutMappingToQuestionMark)
+{
+    const EbcdicCodec *ccsid1140 = EbcdicCodec::codecForCcsid(1140);
+
+    ASSERT_THAT(codec->fromUnicode(QChar(0x20ac)), Eq(EbcdicQuestionMark));
+    ASSERT_THAT(ccsid1140->fromUnicode(QChar(0x00a4)), Eq(EbcdicQuestionMark));
+}
+
+TEST_F(AnEbcdicCodec, translatesEveryCharacterBackForEachCcsid)
+{
+    const int ccsids[]{37, 273, 277, 280, 284, 285, 297, 500,
+                       1140, 1141, 1142, 1143, 1144, 1145, 1146, 1147, 1148, 1149};
+
+    for (int ccsid : ccsids) {
+        const EbcdicCodec *ccsidCodec = EbcdicCodec::codecForCcsid(ccsid);
+        ASSERT_THAT(ccsidCodec, NotNull()) << "CCSID " << ccsid;
+
+        for (int ebcdic = 0; ebcdic <= 0xff; ++ebcdic) {
+            ASSERT_THAT(ccsidCodec->fromUnicode(ccsidCodec->toUnicode(ebcdic)), Eq(ebcdic))
+                    << "CCSID " << ccsid << ", character " << ebcdic;
+        }
+    }
+}
+
+TEST_F(AnEbcdicCodec, translatesText)
+{
+    const QByteArray ebcdic("\xc1\xc2\xc3", 3);
+
+    ASSERT_THAT(codec->toUnicode(ebcdic), Eq(QString("ABC")));
+    ASSERT_THAT(codec->fromUnicode(QString("ABC")), Eq(ebcdic));
+}
+
+TEST_F(AnEbcdicCodec, translatesCellsAndShowsAttributesAndNulsAsBlanks)
+{
+    const unsigned char cells[]{0xc1, 0x00, 0x20, 0x3f, 0x40, 0xc2};
+    QChar text[6];
+
+    codec->cellsToUnicode(cells, 6, text);
+
+    ASSERT_THAT(text[0].unicode(), Eq('A'));
+    ASSERT_THAT(text[1].unicode(), Eq(' '));
+    ASSERT_THAT(text[2].unicode(), Eq(' '));
+    ASSERT_THAT(text[3].unicode(), Eq(' '));
+    ASSERT_THAT(text[4].unicode(), Eq(' '));
+    ASSERT_THAT(text[5].unicode(), Eq('B'));
+}
+
+TEST_F(AnEbcdicCodec, translatesCellsLikeSingleCharactersForEachCcsid)
+{
+    const int ccsids[]{37, 500, 1140, 1141, 285};
+    // a full 27x132 screen plus an odd tail, with every byte value
+    const int size = 27 * 132 + 7;
+    std::vector<unsigned char> cells(size);
+    for (int i = 0; i < size; ++i) {
+        cells[i] = (i * 7) & 0xff;
+    }
+
+    for (int ccsid : ccsids) {
+        const EbcdicCodec *ccsidCodec = EbcdicCodec::codecForCcsid(ccsid);
+        for (int length : {size, 15, 31, 47, 63, 64, 80, 132}) {
+            for (auto conversion : {EbcdicCodec::CellConversion::Fastest, EbcdicCodec::CellConversion::Scalar,
+                                    EbcdicCodec::CellConversion::Vector}) {
+                std::vector<QChar> text(length);
+
+                ccsidCodec->cellsToUnicode(cells.data(), length, text.data(), conversion);
+
+                for (int i = 0; i < length; ++i) {
+                    const unsigned char cell = cells[i];
+                    const bool hidden = cell == 0x00 || (cell >= 0x20 && cell <= 0x3f);
+                    ASSERT_THAT(text[i].unicode(), Eq(ccsidCodec->toUnicode(hidden ? 0x40 : cell).unicode()))
+                            << "CCSID " << ccsid << ", length " << length << ", cell " << i;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QByteArray>
+#include <QList>
+
+#include <gdsrecordframer.h>
+using namespace q5250;
+
+class AGdsRecordFramer : public Test
+{
+public:
+    GdsRecordFramer framer;
+    QList<QByteArray> records;
+
+    bool frame(const QByteArray &data)
+    {
+        return framer.frame(data, [this](const QByteArray &record) { records.append(record); });
+    }
+
+    QByteArray createRecord(const QByteArray &data)
+    {
+        const char length = 10 + data.size();
+        const char gdsHeader[] { 0x00, length, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x03 };
+        return QByteArray(gdsHeader, 10) + data;
+    }
+};
+
+TEST_F(AGdsRecordFramer, handsOutCompleteRecord)
+{
+    const QByteArray record = createRecord("\x04\x40");
+
+    ASSERT_TRUE(frame(record));
+
+    ASSERT_THAT(records.size(), Eq(1));
+    ASSERT_THAT(records.at(0), Eq(record));
+}
+
+TEST_F(AGdsRecordFramer, splitsConsecutiveRecordsByLength)
+{
+    const QByteArray first = createRecord("\x04\x40");
+    const QByteArray second = createRecord("\x04\x11\x00\x18");
+
+    frame(first + second);
+
+    ASSERT_THAT(records.size(), Eq(2));
+    ASSERT_THAT(records.at(0), Eq(first));
+    ASSERT_THAT(records.at(1), Eq(second));
+}
+
+TEST_F(AGdsRecordFramer, collectsRecordSplitAcrossChunks)
+{
+    const QByteArray record = createRecord("\x04\x11\x00\x18");
+
+    frame(record.left(2));
+    frame(record.mid(2, 9));
+    ASSERT_THAT(records.size(), Eq(0));
+    ASSERT_THAT(framer.pendingRecordSize(), Eq(11));
+
+    frame(record.mid(11));
+
+    ASSERT_THAT(records.size(), Eq(1));
+    ASSERT_THAT(records.at(0), Eq(record));
+    ASSERT_THAT(framer.pendingRecordSize(), Eq(0));
+}
+
+TEST_F(AGdsRecordFramer, handsOutRecordFollowingSplitRecord)
+{
+    const QByteArray first = createRecord("\x04\x40");
+    const QByteArray second = createRecord("\x04\x11\x00\x18");
+
+    frame(first.left(5));
+    frame(first.mid(5) + second);
+
+    ASSERT_THAT(records.size(), Eq(2));
+    ASSERT_THAT(records.at(0), Eq(first));
+    ASSERT_THAT(records.at(1), Eq(second));
+}
+
+TEST_F(AGdsRecordFramer, rejectsRecordLengthShorterThanHeader)
+{
+    const char gdsHeader[] { 0x00, 0x04, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x03 };
+
+    ASSERT_FALSE(frame(QByteArray(gdsHeader, 10)));
+    ASSERT_THAT(records.size(), Eq(0));
+}
+
+TEST_F(AGdsRecordFramer, rejectsWrongRecordType)
+{
+    QByteArray record = createRecord("\x04\x40");
+    record[3] = 0x00;
+
+    ASSERT_FALSE(frame(record));
+    ASSERT_THAT(records.size(), Eq(0));
+}
+
+TEST_F(AGdsRecordFramer, rejectsMalformedHeaderSplitAcrossChunks)
+{
+    const char gdsHeader[] { 0x00, 0x0c, 0x00, 0x00 };
+
+    ASSERT_TRUE(frame(QByteArray(gdsHeader, 3)));
+    ASSERT_FALSE(frame(QByteArray(gdsHeader + 3, 1)));
+    ASSERT_THAT(framer.pendingRecordSize(), Eq(0));
+}
+
+TEST_F(AGdsRecordFramer, continuesWithNextChunkAfterMalformedData)
+{
+    const QByteArray record = createRecord("\x04\x40");
+
+    frame(QByteArray("garbage"));
+    frame(record);
+
+    ASSERT_THAT(records.size(), Eq(1));
+    ASSERT_THAT(records.at(0), Eq(record));
+}
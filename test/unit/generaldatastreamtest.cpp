@@ -29,6 +29,7 @@ using namespace testing;
 #include <QByteArray>
 
 #include <generaldatastream.h>
+#include "allocationcounter.h"
 using namespace q5250;
 
 TEST(AGeneralDataStream, isReadOnlyIfCreatedByConstructorWithBuffer)
@@ -119,6 +120,57 @@ TEST(AGeneralDataStream, doesNotSeekToPreviousByteBeyondStartOfContent)
     ASSERT_THAT(stream.readByte(), Eq(0x04));
 }
 
+TEST(AGeneralDataStream, peeksAtNextByteWithoutConsumingIt)
+{
+    const char gdsHeader[] { 0x00, 0x0c, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x03 };
+    QByteArray data = QByteArray::fromRawData(gdsHeader, 10);
+    data += 0x04;       // ESC
+    data += 0x40;       // CU
+    GeneralDataStream stream(data);
+
+    ASSERT_THAT(stream.peekByte(), Eq(0x04));
+    ASSERT_THAT(stream.readByte(), Eq(0x04));
+}
+
+TEST(AGeneralDataStream, skipsBytesReadDirectlyFromData)
+{
+    const char gdsHeader[] { 0x00, 0x0d, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x03 };
+    QByteArray data = QByteArray::fromRawData(gdsHeader, 10);
+    data += "ABC";
+    GeneralDataStream stream(data);
+
+    ASSERT_THAT(stream.endPointer() - stream.readPointer(), Eq(3));
+    ASSERT_THAT(*stream.readPointer(), Eq('A'));
+
+    stream.skip(2);
+    ASSERT_THAT(stream.readByte(), Eq('C'));
+
+    stream.skip(5);
+    ASSERT_TRUE(stream.atEnd());
+}
+
+TEST(AGeneralDataStream, readsZeroBeyondEndOfData)
+{
+    const char gdsHeader[] { 0x00, 0x0b, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x03 };
+    QByteArray data = QByteArray::fromRawData(gdsHeader, 10);
+    data += 0x12;
+    GeneralDataStream stream(data);
+
+    ASSERT_THAT(stream.readWord(), Eq(0));
+    ASSERT_TRUE(stream.atEnd());
+    ASSERT_THAT(stream.readByte(), Eq(0));
+    ASSERT_THAT(stream.peekByte(), Eq(0));
+}
+
+TEST(AGeneralDataStream, isInvalidAndAtEndIfShorterThanHeader)
+{
+    const char gdsHeader[] { 0x00, 0x0a, 0x12, (char)0xa0, 0x00 };
+    GeneralDataStream stream(QByteArray::fromRawData(gdsHeader, 5));
+
+    ASSERT_FALSE(stream.isValid());
+    ASSERT_TRUE(stream.atEnd());
+}
+
 TEST(AGeneralDataStream, addsHeaderToReturnedWriteBuffer)
 {
     const char gdsHeader[] { 0x00, 0x0a, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00 };
@@ -139,3 +191,44 @@ TEST(AGeneralDataStream, returnsDataWrittenToStream)
 
     ASSERT_THAT(stream.toByteArray(), Eq(expectedData));
 }
+
+TEST(AGeneralDataStream, appendsBlocksOfData)
+{
+    const char gdsHeader[] { 0x00, 0x0f, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00 };
+    const QByteArray ArbitraryByteData{"\xc1\xc2\xc3"};
+    QByteArray expectedData = QByteArray::fromRawData(gdsHeader, 10) + ArbitraryByteData + "\x12\x34";
+
+    GeneralDataStream stream;
+    stream.append(ArbitraryByteData.constData(), ArbitraryByteData.size());
+    stream.appendWord(0x1234);
+
+    ASSERT_THAT(stream.toByteArray(), Eq(expectedData));
+}
+
+TEST(AGeneralDataStream, appendsStructsOfBytes)
+{
+    struct SetBufferAddress { quint8 order; quint8 row; quint8 column; };
+    const char gdsHeader[] { 0x00, 0x0d, 0x12, (char)0xa0, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00 };
+    QByteArray expectedData = QByteArray::fromRawData(gdsHeader, 10) + "\x11\x05\x07";
+
+    GeneralDataStream stream;
+    stream.appendStruct(SetBufferAddress{ 0x11, 0x05, 0x07 });
+
+    ASSERT_THAT(stream.toByteArray(), Eq(expectedData));
+}
+
+TEST(AGeneralDataStream, reusesWriteBufferAfterClear)
+{
+    const QByteArray ArbitraryByteData(200, 'A');
+    GeneralDataStream stream;
+    stream.append(ArbitraryByteData.constData(), ArbitraryByteData.size());
+    stream.toByteArray();
+
+    AllocationCounter counter;
+    stream.clear();
+    stream.append(ArbitraryByteData.constData(), ArbitraryByteData.size());
+    QByteArray data = stream.toByteArray();
+
+    ASSERT_THAT(counter.allocations(), Eq(0));
+    ASSERT_THAT(data.size(), Eq(210));
+}
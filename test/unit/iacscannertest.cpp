@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QByteArray>
+
+#include <telnet/iacscanner.h>
+using namespace q5250;
+
+class AnIacScanner : public Test
+{
+public:
+    static const char IAC = '\xff';
+
+    int indexOfInterpretAsCommand(const QByteArray &data) {
+        const char *begin = data.constData();
+        return findInterpretAsCommand(begin, begin + data.size()) - begin;
+    }
+};
+
+TEST_F(AnIacScanner, returnsEndIfDataContainsNoIAC)
+{
+    const QByteArray plainData(100, 'A');
+
+    ASSERT_THAT(indexOfInterpretAsCommand(plainData), Eq(plainData.size()));
+}
+
+TEST_F(AnIacScanner, returnsEndForEmptyRange)
+{
+    ASSERT_THAT(indexOfInterpretAsCommand(QByteArray()), Eq(0));
+}
+
+TEST_F(AnIacScanner, findsIACAtStartOfData)
+{
+    const QByteArray data = QByteArray(1, IAC) + QByteArray(10, 'A');
+
+    ASSERT_THAT(indexOfInterpretAsCommand(data), Eq(0));
+}
+
+TEST_F(AnIacScanner, findsIACInTailOfData)
+{
+    const QByteArray data = QByteArray(37, 'A') + IAC;
+
+    ASSERT_THAT(indexOfInterpretAsCommand(data), Eq(37));
+}
+
+TEST_F(AnIacScanner, findsFirstOfMultipleIACs)
+{
+    const QByteArray data = QByteArray(70, 'A') + IAC + QByteArray(20, 'A') + IAC;
+
+    ASSERT_THAT(indexOfInterpretAsCommand(data), Eq(70));
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QLoggingCategory>
+
+#include <terminal/protocoltrace.h>
+using namespace q5250;
+
+class AProtocolTrace : public Test
+{
+public:
+    ProtocolTrace trace;
+    QBuffer device;
+
+    void SetUp()
+    {
+        device.open(QIODevice::WriteOnly);
+    }
+
+    void TearDown()
+    {
+        QLoggingCategory::setFilterRules(QString());
+    }
+};
+
+TEST_F(AProtocolTrace, isDisabledWithoutDevice)
+{
+    ASSERT_FALSE(trace.isEnabled());
+}
+
+TEST_F(AProtocolTrace, isEnabledWithDevice)
+{
+    trace.setDevice(&device);
+
+    ASSERT_TRUE(trace.isEnabled());
+}
+
+TEST_F(AProtocolTrace, isDisabledIfCategoryIsDisabled)
+{
+    QLoggingCategory::setFilterRules(QStringLiteral("q5250.protocol.trace.debug=false"));
+
+    trace.setDevice(&device);
+
+    ASSERT_FALSE(trace.isEnabled());
+}
+
+TEST_F(AProtocolTrace, writesFiveByteRecordPerOrder)
+{
+    const char expectedRecords[] { 0x11, 0x05, 0x0a, 0x00, 0x00,
+                                   0x00, 0x00, 0x00, 0x01, 0x2c };
+    trace.setDevice(&device);
+
+    trace.record(0x11, 5, 10);
+    trace.record(0x00, 0, 0, 300);
+    trace.flush();
+
+    ASSERT_THAT(device.data(), Eq(QByteArray(expectedRecords, 10)));
+}
+
+TEST_F(AProtocolTrace, collectsRecordsUntilFlushed)
+{
+    trace.setDevice(&device);
+
+    trace.record(0x11, 5, 10);
+
+    ASSERT_TRUE(device.data().isEmpty());
+}
+
+TEST_F(AProtocolTrace, writesCollectedRecordsOnDestruction)
+{
+    {
+        ProtocolTrace scopedTrace;
+        scopedTrace.setDevice(&device);
+        scopedTrace.record(0x01, 0, 0);
+    }
+
+    ASSERT_THAT(device.data().size(), Eq(ProtocolTrace::RecordSize));
+}
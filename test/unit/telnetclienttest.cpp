@@ -41,6 +41,7 @@ public:
     MOCK_METHOD2(connectToHost, void(const QString&, quint16));
 
     MOCK_METHOD0(readAll, QByteArray());
+    MOCK_METHOD2(read, qint64(char*, qint64));
     MOCK_METHOD1(write, void(const QByteArray&));
 
 protected:
@@ -48,12 +49,25 @@ protected:
     MOCK_METHOD0(readyRead, void());
 };
 
+ACTION_P(CopyReceivedData, data)
+{
+    memcpy(arg0, data.constData(), data.size());
+    return data.size();
+}
+
 class ATelnetClient : public Test
 {
 public:
     QByteArray ArbitraryRawData{"A"};
+    QByteArray EndOfRecordCommand{"\xff\xef"};
     static const char IAC = '\xff';
 
+    void receive(TelnetConnectionMock &connection, const QByteArray &data) {
+        EXPECT_CALL(connection, read(_, _))
+            .WillOnce(CopyReceivedData(data))
+            .WillRepeatedly(Return(0));
+    }
+
     QByteArray optionCommand(TelnetCommand command, TelnetOption option) {
         QByteArray optionNegotiation;
 
@@ -83,17 +97,17 @@ TEST_F(ATelnetClient, readsDataFromConnectionWhenReceivedReadyRead)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(ArbitraryRawData));
+    EXPECT_CALL(connection, read(NotNull(), Gt(0))).WillOnce(Return(0));
 
     client.readyRead();
 }
 
-TEST_F(ATelnetClient, emitsDataReceivedForRawData)
+TEST_F(ATelnetClient, emitsDataReceivedForRawDataRecord)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
     QSignalSpy spy(&client, SIGNAL(dataReceived(QByteArray)));
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(ArbitraryRawData));
+    receive(connection, ArbitraryRawData + EndOfRecordCommand);
 
     client.readyRead();
 
@@ -105,7 +119,7 @@ TEST_F(ATelnetClient, deniesOfferToUseUnsupportedOption)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(optionCommand(TelnetCommand::WILL, TelnetOption::ECHO)));
+    receive(connection, optionCommand(TelnetCommand::WILL, TelnetOption::ECHO));
     EXPECT_CALL(connection, write(optionCommand(TelnetCommand::DONT, TelnetOption::ECHO)));
 
     client.readyRead();
@@ -115,7 +129,7 @@ TEST_F(ATelnetClient, deniesRequestToUseUnsupportedOption)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(optionCommand(TelnetCommand::DO, TelnetOption::ECHO)));
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::ECHO));
     EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WONT, TelnetOption::ECHO)));
 
     client.readyRead();
@@ -127,12 +141,9 @@ TEST_F(ATelnetClient, acknowledgesTransmitBinaryOptionNegotiation)
     TelnetClient client(&connection);
     QByteArray transmitBinaryNegotiation = optionCommand(TelnetCommand::DO, TelnetOption::TRANSMIT_BINARY)
                                          + optionCommand(TelnetCommand::WILL, TelnetOption::TRANSMIT_BINARY);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(transmitBinaryNegotiation));
-    {
-        InSequence replies;
-        EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::TRANSMIT_BINARY)));
-        EXPECT_CALL(connection, write(optionCommand(TelnetCommand::DO, TelnetOption::TRANSMIT_BINARY)));
-    }
+    receive(connection, transmitBinaryNegotiation);
+    EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::TRANSMIT_BINARY)
+                                + optionCommand(TelnetCommand::DO, TelnetOption::TRANSMIT_BINARY)));
 
     client.readyRead();
 }
@@ -141,7 +152,7 @@ TEST_F(ATelnetClient, acknowledgesNewEnvironOptionRequest)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(optionCommand(TelnetCommand::DO, TelnetOption::NEW_ENVIRON)));
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::NEW_ENVIRON));
     EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::NEW_ENVIRON)));
 
     client.readyRead();
@@ -151,7 +162,7 @@ TEST_F(ATelnetClient, acknowledgesTerminalTypeOptionRequest)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(optionCommand(TelnetCommand::DO, TelnetOption::TERMINAL_TYPE)));
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::TERMINAL_TYPE));
     EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::TERMINAL_TYPE)));
 
     client.readyRead();
@@ -161,7 +172,7 @@ TEST_F(ATelnetClient, acknowledgesEndOfRecordOptionRequest)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD)));
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD));
     EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::END_OF_RECORD)));
 
     client.readyRead();
@@ -171,7 +182,7 @@ TEST_F(ATelnetClient, statesTerminalTypeOnRequest)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::SEND, QByteArray())));
+    receive(connection, subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::SEND, QByteArray()));
     EXPECT_CALL(connection, write(subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::IS, QByteArray{"UNKNOWN"})));
 
     client.readyRead();
@@ -181,7 +192,7 @@ TEST_F(ATelnetClient, statesSetTerminalTypeOnRequest)
 {
     TelnetConnectionMock connection;
     TelnetClient client(&connection);
-    EXPECT_CALL(connection, readAll()).WillOnce(Return(subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::SEND, QByteArray())));
+    receive(connection, subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::SEND, QByteArray()));
     EXPECT_CALL(connection, write(subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::IS, QByteArray{"IBM-3477-FC"})));
 
     client.setTerminalType("IBM-3477-FC");
@@ -196,3 +207,170 @@ TEST_F(ATelnetClient, writesDataToConnectionWithEndOfRecordMarkerAppended)
 
     client.sendData(ArbitraryRawData);
 }
+
+TEST_F(ATelnetClient, emitsDataReceivedForRecordSplitAcrossMultipleReads)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    QSignalSpy spy(&client, SIGNAL(dataReceived(QByteArray)));
+
+    receive(connection, QByteArray("AB"));
+    client.readyRead();
+    Mock::VerifyAndClearExpectations(&connection);
+    receive(connection, QByteArray("CD") + EndOfRecordCommand);
+    client.readyRead();
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(QByteArray("ABCD")));
+}
+
+TEST_F(ATelnetClient, sendsNoOptionOffersOnConnectByDefault)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    EXPECT_CALL(connection, write(_)).Times(0);
+
+    client.connected();
+}
+
+TEST_F(ATelnetClient, sendsOptionOffersOnConnectWithSingleWrite)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::TERMINAL_TYPE)
+                                + optionCommand(TelnetCommand::WILL, TelnetOption::END_OF_RECORD)
+                                + optionCommand(TelnetCommand::WILL, TelnetOption::TRANSMIT_BINARY)
+                                + optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD)
+                                + optionCommand(TelnetCommand::DO, TelnetOption::TRANSMIT_BINARY)));
+
+    client.setOfferOptionsOnConnect(true);
+    client.connected();
+}
+
+TEST_F(ATelnetClient, doesNotAcknowledgeAcceptedOptionOffer)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    EXPECT_CALL(connection, write(_));
+    client.setOfferOptionsOnConnect(true);
+    client.connected();
+    Mock::VerifyAndClearExpectations(&connection);
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD)
+                      + optionCommand(TelnetCommand::WILL, TelnetOption::END_OF_RECORD));
+    EXPECT_CALL(connection, write(_)).Times(0);
+
+    client.readyRead();
+}
+
+TEST_F(ATelnetClient, sendsRepliesToReceivedChunkWithSingleWrite)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::TERMINAL_TYPE)
+                      + subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::SEND, QByteArray()));
+    EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::TERMINAL_TYPE)
+                                + subnegotiation(TelnetOption::TERMINAL_TYPE, SubnegotiationCommand::IS, QByteArray{"UNKNOWN"})));
+
+    client.readyRead();
+}
+
+TEST_F(ATelnetClient, ignoresRepeatedRequestForEnabledOption)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD)
+                      + optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD));
+    EXPECT_CALL(connection, write(optionCommand(TelnetCommand::WILL, TelnetOption::END_OF_RECORD)));
+
+    client.readyRead();
+}
+
+TEST_F(ATelnetClient, acknowledgesDisableOfEnabledOption)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    receive(connection, optionCommand(TelnetCommand::WILL, TelnetOption::TRANSMIT_BINARY)
+                      + optionCommand(TelnetCommand::WONT, TelnetOption::TRANSMIT_BINARY));
+    EXPECT_CALL(connection, write(optionCommand(TelnetCommand::DO, TelnetOption::TRANSMIT_BINARY)
+                                + optionCommand(TelnetCommand::DONT, TelnetOption::TRANSMIT_BINARY)));
+
+    client.readyRead();
+
+    ASSERT_FALSE(client.isRemoteOptionEnabled(TelnetOption::TRANSMIT_BINARY));
+}
+
+TEST_F(ATelnetClient, ignoresDisableOfDisabledOption)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    receive(connection, optionCommand(TelnetCommand::DONT, TelnetOption::ECHO)
+                      + optionCommand(TelnetCommand::WONT, TelnetOption::ECHO));
+    EXPECT_CALL(connection, write(_)).Times(0);
+
+    client.readyRead();
+}
+
+TEST_F(ATelnetClient, doesNotAcknowledgeRefusedOptionOffer)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    EXPECT_CALL(connection, write(_));
+    client.setOfferOptionsOnConnect(true);
+    client.connected();
+    Mock::VerifyAndClearExpectations(&connection);
+    receive(connection, optionCommand(TelnetCommand::DONT, TelnetOption::TERMINAL_TYPE));
+    EXPECT_CALL(connection, write(_)).Times(0);
+
+    client.readyRead();
+
+    ASSERT_FALSE(client.isLocalOptionEnabled(TelnetOption::TERMINAL_TYPE));
+}
+
+TEST_F(ATelnetClient, reportsNegotiatedOptions)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    receive(connection, optionCommand(TelnetCommand::DO, TelnetOption::END_OF_RECORD)
+                      + optionCommand(TelnetCommand::WILL, TelnetOption::TRANSMIT_BINARY)
+                      + optionCommand(TelnetCommand::DO, TelnetOption::ECHO));
+    EXPECT_CALL(connection, write(_));
+
+    client.readyRead();
+
+    ASSERT_TRUE(client.isLocalOptionEnabled(TelnetOption::END_OF_RECORD));
+    ASSERT_FALSE(client.isRemoteOptionEnabled(TelnetOption::END_OF_RECORD));
+    ASSERT_TRUE(client.isRemoteOptionEnabled(TelnetOption::TRANSMIT_BINARY));
+    ASSERT_FALSE(client.isLocalOptionEnabled(TelnetOption::ECHO));
+}
+
+TEST_F(ATelnetClient, repliesEnvironmentOnNewEnvironRequest)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    TelnetEnvironment environment;
+    environment.setDeviceName(QString::fromLatin1("QPADEV\xff"));
+    client.setEnvironment(environment);
+    receive(connection, subnegotiation(TelnetOption::NEW_ENVIRON, SubnegotiationCommand::SEND, QByteArray()));
+    EXPECT_CALL(connection, write(subnegotiation(TelnetOption::NEW_ENVIRON, SubnegotiationCommand::IS,
+                                                 QByteArray("\x03" "DEVNAME" "\x01" "QPADEV\xff\xff"))));
+
+    client.readyRead();
+}
+
+TEST_F(ATelnetClient, escapesInterpretAsCommandBytesInSentData)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    EXPECT_CALL(connection, write(QByteArray("A\xff\xff" "B\xff\xef")));
+
+    client.sendData(QByteArray("A\xff" "B"));
+}
+
+TEST_F(ATelnetClient, writesDataSegmentsAsSingleRecord)
+{
+    TelnetConnectionMock connection;
+    TelnetClient client(&connection);
+    EXPECT_CALL(connection, write(QByteArray("AB\xff\xff" "C\xff\xef")));
+
+    client.sendDataSegments({ QByteArray("A"), QByteArray("B\xff"), QByteArray("C") });
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QByteArray>
+
+#include <telnet/newenvironcode.h>
+#include <telnet/telnetenvironment.h>
+using namespace q5250;
+
+class ATelnetEnvironment : public Test
+{
+public:
+    TelnetEnvironment environment;
+
+    static const char VAR = (char)NewEnvironCode::VAR;
+    static const char VALUE = (char)NewEnvironCode::VALUE;
+    static const char ESC = (char)NewEnvironCode::ESC;
+    static const char USERVAR = (char)NewEnvironCode::USERVAR;
+
+    QByteArray variable(char type, const QByteArray &name, const QByteArray &value) {
+        return QByteArray(1, type) + name + VALUE + value;
+    }
+
+    QByteArray unescape(const QByteArray &value) {
+        QByteArray data;
+        for (int i = 0; i < value.size(); ++i) {
+            if (value.at(i) == ESC) ++i;
+            if (i < value.size()) data.append(value.at(i));
+        }
+        return data;
+    }
+};
+
+TEST_F(ATelnetEnvironment, repliesNothingWithoutVariables)
+{
+    ASSERT_TRUE(environment.reply(QByteArray()).isEmpty());
+}
+
+TEST_F(ATelnetEnvironment, repliesAllVariablesForEmptyRequest)
+{
+    environment.setUser("QUSER");
+    environment.setDeviceName("QPADEV0001");
+    environment.setKeyboardType("USB");
+    environment.setCodePage("37");
+    environment.setCharacterSet("697");
+
+    ASSERT_THAT(environment.reply(QByteArray()), Eq(variable(VAR, "USER", "QUSER")
+                                                  + variable(USERVAR, "DEVNAME", "QPADEV0001")
+                                                  + variable(USERVAR, "KBDTYPE", "USB")
+                                                  + variable(USERVAR, "CODEPAGE", "37")
+                                                  + variable(USERVAR, "CHARSET", "697")));
+}
+
+TEST_F(ATelnetEnvironment, repliesOnlyRequestedVariables)
+{
+    environment.setUser("QUSER");
+    environment.setDeviceName("QPADEV0001");
+    environment.setKeyboardType("USB");
+
+    QByteArray request = QByteArray(1, USERVAR) + "KBDTYPE";
+
+    ASSERT_THAT(environment.reply(request), Eq(variable(USERVAR, "KBDTYPE", "USB")));
+}
+
+TEST_F(ATelnetEnvironment, repliesAllVariablesOfRequestedType)
+{
+    environment.setUser("QUSER");
+    environment.setDeviceName("QPADEV0001");
+
+    ASSERT_THAT(environment.reply(QByteArray(1, USERVAR)), Eq(variable(USERVAR, "DEVNAME", "QPADEV0001")));
+}
+
+TEST_F(ATelnetEnvironment, escapesTypeCodesInsideOfValues)
+{
+    environment.setDeviceName(QString::fromLatin1("A\x01" "B"));
+
+    ASSERT_THAT(environment.reply(QByteArray()), Eq(variable(USERVAR, "DEVNAME", QByteArray("A") + ESC + VALUE + "B")));
+}
+
+TEST_F(ATelnetEnvironment, sendsNoPasswordWithoutServerSeed)
+{
+    environment.setUser("QUSER");
+    environment.setPassword("secret");
+
+    const QByteArray requests[] = { QByteArray(), QByteArray(1, USERVAR),
+                                    QByteArray(1, USERVAR) + "IBMSUBSPW" };
+
+    for (const QByteArray &request : requests) {
+        QByteArray reply = environment.reply(request);
+
+        ASSERT_FALSE(reply.contains("secret"));
+        ASSERT_FALSE(reply.contains("IBMSUBSPW"));
+    }
+}
+
+TEST_F(ATelnetEnvironment, repliesPlainPasswordWithoutServerSeedWhenAllowed)
+{
+    environment.setUser("QUSER");
+    environment.setPassword("secret");
+    environment.setAllowPlainPassword(true);
+
+    ASSERT_THAT(environment.reply(QByteArray()), Eq(variable(VAR, "USER", "QUSER")
+                                                  + variable(USERVAR, "IBMRSEED", "")
+                                                  + variable(USERVAR, "IBMSUBSPW", "secret")));
+}
+
+TEST_F(ATelnetEnvironment, sendsNoPlainPasswordWithNonAsciiCharacters)
+{
+    environment.setUser("QUSER");
+    environment.setPassword(QString::fromUtf8("s\xc3\xa9" "cret"));
+    environment.setAllowPlainPassword(true);
+
+    ASSERT_FALSE(environment.reply(QByteArray()).contains("IBMSUBSPW"));
+}
+
+TEST_F(ATelnetEnvironment, repliesPasswordSubstituteForServerSeed)
+{
+    const QByteArray serverSeed("\x01\x02\x03\x04\x05\x06\x07\x08", 8);
+    const QByteArray escapedServerSeed = QByteArray(1, ESC) + '\x01' + ESC + '\x02' + ESC + '\x03' + "\x04\x05\x06\x07\x08";
+    environment.setUser("QUSER");
+    environment.setPassword("secret");
+
+    QByteArray reply = environment.reply(QByteArray(1, USERVAR) + "IBMRSEED" + escapedServerSeed + VAR + USERVAR);
+
+    QByteArray seedVariable = QByteArray(1, USERVAR) + "IBMRSEED" + VALUE;
+    QByteArray passwordVariable = QByteArray(1, USERVAR) + "IBMSUBSPW" + VALUE;
+    int seedStart = reply.indexOf(seedVariable) + seedVariable.size();
+    int passwordStart = reply.indexOf(passwordVariable);
+    ASSERT_THAT(seedStart, Gt(0));
+    ASSERT_THAT(passwordStart, Gt(seedStart));
+    QByteArray clientSeed = unescape(reply.mid(seedStart, passwordStart - seedStart));
+    QByteArray substitute = unescape(reply.mid(passwordStart + passwordVariable.size()));
+    ASSERT_THAT(clientSeed.size(), Eq(8));
+    ASSERT_THAT(substitute, Eq(passwordSubstitute("QUSER", "secret", serverSeed, clientSeed)));
+}
+
+TEST_F(ATelnetEnvironment, calculatesSha1PasswordSubstitute)
+{
+    const QByteArray serverSeed("\x01\x02\x03\x04\x05\x06\x07\x08", 8);
+    const QByteArray clientSeed("\x11\x12\x13\x14\x15\x16\x17\x18", 8);
+
+    QByteArray substitute = passwordSubstitute("qsecofr", "secret", serverSeed, clientSeed);
+
+    ASSERT_THAT(substitute, Eq(QByteArray("\xc5\x8e\x98\x07\x33\xd9\x09\xb8\x0e\xb3"
+                                          "\x48\x2b\x59\x3a\x67\xc7\x02\xe0\xd7\x7d", 20)));
+}
@@ -90,23 +90,32 @@ void ASSERT_SUBNEGOTIATION(const QList<QVariant> &signalArgs, TelnetOption optio
     ASSERT_THAT(subnegotiation.parameters, Eq(parameters));
 }
 
-TEST_F(ATelnetParser, emitsDataReceivedWhenParsingRawData)
+TEST_F(ATelnetParser, emitsDataReceivedWhenParsingRawDataRecord)
 {
     QSignalSpy spy(&parser, SIGNAL(dataReceived(QByteArray)));
 
-    parser.parse(ArbitraryRawData);
+    parser.parse(ArbitraryRawData + EndOfRecordCommand);
 
     ASSERT_THAT(spy.count(), Eq(1));
     ASSERT_THAT(spy[0][0].toByteArray(), Eq(ArbitraryRawData));
 }
 
+TEST_F(ATelnetParser, doesNotEmitDataReceivedForIncompleteRecord)
+{
+    QSignalSpy spy(&parser, SIGNAL(dataReceived(QByteArray)));
+
+    parser.parse(ArbitraryRawData);
+
+    ASSERT_THAT(spy.count(), Eq(0));
+}
+
 TEST_F(ATelnetParser, replacesEscapedIACBytesInRawData)
 {
     QSignalSpy spy(&parser, SIGNAL(dataReceived(QByteArray)));
-    const char rawData[]{IAC, IAC, 'A', 'B'};
+    const char rawData[]{IAC, IAC, 'A', 'B', IAC, (char)TelnetCommand::EOR};
     const char expectedData[]{IAC, 'A', 'B'};
 
-    parser.parse(QByteArray::fromRawData(rawData, 4));
+    parser.parse(QByteArray::fromRawData(rawData, 6));
 
     ASSERT_THAT(spy.count(), Eq(1));
     ASSERT_THAT(spy[0][0].toByteArray(), Eq(QByteArray::fromRawData(expectedData, 3)));
@@ -169,3 +178,61 @@ TEST_F(ATelnetParser, splitsMultipleRawDataRecords)
     ASSERT_THAT(spy[0][0].toByteArray(), Eq(ArbitraryRawData));
     ASSERT_THAT(spy[1][0].toByteArray(), Eq(ArbitraryRawData));
 }
+
+TEST_F(ATelnetParser, reassemblesRecordSplitAcrossMultipleChunks)
+{
+    QSignalSpy spy(&parser, SIGNAL(dataReceived(QByteArray)));
+
+    parser.parse(QByteArray("AB"));
+    parser.parse(QByteArray("CD") + EndOfRecordCommand);
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(QByteArray("ABCD")));
+}
+
+TEST_F(ATelnetParser, handlesEndOfRecordCommandSplitAcrossChunks)
+{
+    QSignalSpy spy(&parser, SIGNAL(dataReceived(QByteArray)));
+
+    parser.parse(ArbitraryRawData + IAC);
+    parser.parse(EndOfRecordCommand.mid(1));
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(ArbitraryRawData));
+}
+
+TEST_F(ATelnetParser, handlesEscapedIACSplitAcrossChunks)
+{
+    QSignalSpy spy(&parser, SIGNAL(dataReceived(QByteArray)));
+    const char expectedData[]{'A', IAC, 'B'};
+
+    parser.parse(QByteArray("A") + IAC);
+    parser.parse(QByteArray(1, IAC) + 'B' + EndOfRecordCommand);
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(QByteArray::fromRawData(expectedData, 3)));
+}
+
+TEST_F(ATelnetParser, handlesOptionNegotiationSplitAcrossChunks)
+{
+    QSignalSpy spy(&parser, SIGNAL(optionNegotiationReceived(q5250::OptionNegotiation)));
+    const QByteArray data = doOption(TelnetOption::END_OF_RECORD);
+
+    parser.parse(data.left(2));
+    parser.parse(data.mid(2));
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_OPTION_NEGOTIATION(spy[0], TelnetCommand::DO, TelnetOption::END_OF_RECORD);
+}
+
+TEST_F(ATelnetParser, emitsOptionNegotiationReceivedInsideOfRecord)
+{
+    QSignalSpy dataSpy(&parser, SIGNAL(dataReceived(QByteArray)));
+    QSignalSpy optionSpy(&parser, SIGNAL(optionNegotiationReceived(q5250::OptionNegotiation)));
+
+    parser.parse(QByteArray("A") + doOption(TelnetOption::END_OF_RECORD) + "B" + EndOfRecordCommand);
+
+    ASSERT_THAT(optionSpy.count(), Eq(1));
+    ASSERT_THAT(dataSpy.count(), Eq(1));
+    ASSERT_THAT(dataSpy[0][0].toByteArray(), Eq(QByteArray("AB")));
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QByteArray>
+
+#include <telnet/telnetreceivebuffer.h>
+using namespace q5250;
+
+class ATelnetReceiveBuffer : public Test
+{
+public:
+    TelnetReceiveBuffer buffer;
+    QByteArray ArbitraryRawData{"ABC"};
+
+    void writeAllReceivedBytes() {
+        while (!buffer.atEnd()) {
+            buffer.writeByte(buffer.readByte());
+        }
+    }
+};
+
+TEST_F(ATelnetReceiveBuffer, isAtEndIfEmpty)
+{
+    ASSERT_TRUE(buffer.atEnd());
+}
+
+TEST_F(ATelnetReceiveBuffer, reservesRequestedSpace)
+{
+    const int requestedSize = 2 * buffer.capacity();
+
+    buffer.reserve(requestedSize);
+
+    ASSERT_THAT(buffer.capacity(), Ge(requestedSize));
+}
+
+TEST_F(ATelnetReceiveBuffer, readsCommittedBytes)
+{
+    char *data = buffer.reserve(ArbitraryRawData.size());
+    memcpy(data, ArbitraryRawData.constData(), ArbitraryRawData.size());
+
+    buffer.commit(ArbitraryRawData.size());
+
+    ASSERT_THAT(buffer.readByte(), Eq('A'));
+    ASSERT_THAT(buffer.readByte(), Eq('B'));
+    ASSERT_THAT(buffer.readByte(), Eq('C'));
+    ASSERT_TRUE(buffer.atEnd());
+}
+
+TEST_F(ATelnetReceiveBuffer, returnsWrittenBytesAsRecord)
+{
+    buffer.append(ArbitraryRawData.constData(), ArbitraryRawData.size());
+    writeAllReceivedBytes();
+
+    ASSERT_THAT(buffer.takeRecord(), Eq(ArbitraryRawData));
+}
+
+TEST_F(ATelnetReceiveBuffer, removesSkippedBytesFromRecord)
+{
+    buffer.append("A\xff\xf1" "B", 4);
+
+    buffer.writeByte(buffer.readByte());
+    buffer.readByte();
+    buffer.readByte();
+    buffer.writeByte(buffer.readByte());
+
+    ASSERT_THAT(buffer.takeRecord(), Eq(QByteArray("AB")));
+}
+
+TEST_F(ATelnetReceiveBuffer, movesRunOfDataBehindPreviouslyWrittenBytes)
+{
+    buffer.append("A\xff\xf1" "BC", 5);
+
+    buffer.writeByte(buffer.readByte());
+    buffer.readByte();
+    buffer.readByte();
+    buffer.writeRun(2);
+
+    ASSERT_TRUE(buffer.atEnd());
+    ASSERT_THAT(buffer.takeRecord(), Eq(QByteArray("ABC")));
+}
+
+TEST_F(ATelnetReceiveBuffer, keepsIncompleteRecordWhenReservingMoreSpace)
+{
+    buffer.append("A", 1);
+    writeAllReceivedBytes();
+
+    buffer.reserve(4 * buffer.capacity());
+    buffer.append("B", 1);
+    writeAllReceivedBytes();
+
+    ASSERT_THAT(buffer.pendingRecordSize(), Eq(2));
+    ASSERT_THAT(buffer.takeRecord(), Eq(QByteArray("AB")));
+}
+
+TEST_F(ATelnetReceiveBuffer, startsNewRecordAfterRecordWasTaken)
+{
+    buffer.append(ArbitraryRawData.constData(), ArbitraryRawData.size());
+    writeAllReceivedBytes();
+    buffer.takeRecord();
+
+    buffer.append("D", 1);
+    writeAllReceivedBytes();
+
+    ASSERT_THAT(buffer.takeRecord(), Eq(QByteArray("D")));
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2014, Christian Loose
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <QByteArray>
+
+#include <telnet/telnetsendbuffer.h>
+using namespace q5250;
+
+class ATelnetSendBuffer : public Test
+{
+public:
+    TelnetSendBuffer buffer;
+    QByteArray ArbitraryRawData{"ABC"};
+    static const char IAC = '\xff';
+};
+
+TEST_F(ATelnetSendBuffer, isEmptyAfterCreation)
+{
+    ASSERT_TRUE(buffer.isEmpty());
+}
+
+TEST_F(ATelnetSendBuffer, keepsAppendedDataUnchanged)
+{
+    buffer.append(QByteArray("A") + IAC);
+
+    ASSERT_THAT(buffer.data(), Eq(QByteArray("A") + IAC));
+}
+
+TEST_F(ATelnetSendBuffer, copiesDataWithoutInterpretAsCommand)
+{
+    buffer.appendEscaped(ArbitraryRawData);
+
+    ASSERT_THAT(buffer.data(), Eq(ArbitraryRawData));
+}
+
+TEST_F(ATelnetSendBuffer, doublesInterpretAsCommandBytes)
+{
+    buffer.appendEscaped(QByteArray(1, IAC) + "AB" + IAC + IAC);
+
+    ASSERT_THAT(buffer.data(), Eq(QByteArray(2, IAC) + "AB" + QByteArray(4, IAC)));
+}
+
+TEST_F(ATelnetSendBuffer, doublesInterpretAsCommandBytesInsideOfLongData)
+{
+    const QByteArray run(100, 'A');
+
+    buffer.appendEscaped(run + IAC + run);
+
+    ASSERT_THAT(buffer.data(), Eq(run + IAC + IAC + run));
+}
+
+TEST_F(ATelnetSendBuffer, growsBeyondInitialCapacity)
+{
+    TelnetSendBuffer smallBuffer(4);
+    const QByteArray data(10, IAC);
+
+    smallBuffer.appendEscaped(data);
+
+    ASSERT_THAT(smallBuffer.data(), Eq(QByteArray(20, IAC)));
+}
+
+TEST_F(ATelnetSendBuffer, keepsCapacityWhenCleared)
+{
+    buffer.append(QByteArray(2 * buffer.capacity(), 'A'));
+    const int capacity = buffer.capacity();
+
+    buffer.clear();
+
+    ASSERT_TRUE(buffer.isEmpty());
+    ASSERT_THAT(buffer.capacity(), Eq(capacity));
+}
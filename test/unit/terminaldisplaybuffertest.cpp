@@ -26,6 +26,9 @@
 #include <gmock/gmock.h>
 using namespace testing;
 
+#include <vector>
+
+#include <terminal/ebcdiccodec.h>
 #include <terminal/field.h>
 #include <terminal/terminaldisplaybuffer.h>
 using namespace q5250;
@@ -76,6 +79,42 @@ TEST_F(ATerminalDisplayBuffer, handlesAddressOverflowingHeightAndWidth)
     ASSERT_THAT(displayBuffer->characterAt(1, 1), Eq(ArbitraryCharacter));
 }
 
+TEST_F(ATerminalDisplayBuffer, writesRunAtBufferAddress)
+{
+    const unsigned char run[]{'A', 'B', 'C'};
+    displayBuffer->setBufferAddress(79, 1);
+
+    displayBuffer->writeRun(run, 3);
+
+    ASSERT_THAT(displayBuffer->characterAt(79, 1), Eq('A'));
+    ASSERT_THAT(displayBuffer->characterAt(80, 1), Eq('B'));
+    ASSERT_THAT(displayBuffer->characterAt(1, 2), Eq('C'));
+}
+
+TEST_F(ATerminalDisplayBuffer, advancesAddressPastWrittenRun)
+{
+    const unsigned char run[]{'A', 'B', 'C'};
+    displayBuffer->setBufferAddress(79, 1);
+
+    displayBuffer->writeRun(run, 3);
+
+    ASSERT_THAT(displayBuffer->bufferColumn(), Eq(2));
+    ASSERT_THAT(displayBuffer->bufferRow(), Eq(2));
+}
+
+TEST_F(ATerminalDisplayBuffer, wrapsRunAtEndOfBuffer)
+{
+    const unsigned char run[]{'A', 'B', 'C'};
+    displayBuffer->setBufferAddress(79, 25);
+
+    displayBuffer->writeRun(run, 3);
+
+    ASSERT_THAT(displayBuffer->characterAt(80, 25), Eq('B'));
+    ASSERT_THAT(displayBuffer->characterAt(1, 1), Eq('C'));
+    ASSERT_THAT(displayBuffer->bufferColumn(), Eq(2));
+    ASSERT_THAT(displayBuffer->bufferRow(), Eq(1));
+}
+
 TEST_F(ATerminalDisplayBuffer, repeatsCharacterFromSetAddressToPassedAddress)
 {
     unsigned char startRow = 2;
@@ -91,6 +130,214 @@ TEST_F(ATerminalDisplayBuffer, repeatsCharacterFromSetAddressToPassedAddress)
     ASSERT_THAT(displayBuffer->characterAt(endColumn, endRow), Eq(ArbitraryCharacter));
 }
 
+TEST_F(ATerminalDisplayBuffer, repeatsCharacterAcrossRows)
+{
+    displayBuffer->setBufferAddress(80, 1);
+
+    displayBuffer->repeatCharacterToAddress(2, 2, ArbitraryCharacter);
+
+    ASSERT_THAT(displayBuffer->characterAt(80, 1), Eq(ArbitraryCharacter));
+    ASSERT_THAT(displayBuffer->characterAt(2, 2), Eq(ArbitraryCharacter));
+    ASSERT_THAT(displayBuffer->characterAt(3, 2), Eq('\0'));
+}
+
+TEST_F(ATerminalDisplayBuffer, advancesAddressPastRepeatedCharacters)
+{
+    displayBuffer->setBufferAddress(5, 2);
+
+    displayBuffer->repeatCharacterToAddress(80, 2, ArbitraryCharacter);
+
+    ASSERT_THAT(displayBuffer->bufferColumn(), Eq(1));
+    ASSERT_THAT(displayBuffer->bufferRow(), Eq(3));
+}
+
+TEST_F(ATerminalDisplayBuffer, fillsWholeBufferWithRepeatedCharacter)
+{
+    displayBuffer->setBufferAddress(1, 1);
+
+    displayBuffer->repeatCharacterToAddress(80, 25, ArbitraryCharacter);
+
+    ASSERT_THAT(displayBuffer->characterAt(1, 1), Eq(ArbitraryCharacter));
+    ASSERT_THAT(displayBuffer->characterAt(80, 25), Eq(ArbitraryCharacter));
+    ASSERT_THAT(displayBuffer->bufferColumn(), Eq(1));
+    ASSERT_THAT(displayBuffer->bufferRow(), Eq(1));
+}
+
+TEST_F(ATerminalDisplayBuffer, wrapsRepeatedCharactersAtEndOfBuffer)
+{
+    displayBuffer->setBufferAddress(80, 25);
+
+    displayBuffer->repeatCharacterToAddress(1, 1, ArbitraryCharacter);
+
+    ASSERT_THAT(displayBuffer->characterAt(80, 25), Eq(ArbitraryCharacter));
+    ASSERT_THAT(displayBuffer->characterAt(1, 1), Eq(ArbitraryCharacter));
+    ASSERT_THAT(displayBuffer->characterAt(2, 1), Eq('\0'));
+}
+
+TEST_F(ATerminalDisplayBuffer, returnsCellsOfRow)
+{
+    const unsigned char run[]{0xc1, 0x20, 0xc2};
+    displayBuffer->setBufferAddress(80, 1);
+    displayBuffer->writeRun(run, 3);
+
+    const unsigned char *cells = displayBuffer->rowCells(2);
+
+    ASSERT_THAT(cells[0], Eq(0x20));
+    ASSERT_THAT(cells[1], Eq(0xc2));
+}
+
+TEST_F(ATerminalDisplayBuffer, translatesRowToUnicode)
+{
+    const unsigned char run[]{0xc1, 0x20, 0xc2};
+    const EbcdicCodec *codec = EbcdicCodec::codecForCcsid(500);
+    QChar text[80];
+    displayBuffer->setBufferAddress(79, 1);
+    displayBuffer->writeRun(run, 3);
+
+    displayBuffer->rowToUnicode(2, codec, text);
+
+    ASSERT_THAT(text[0].unicode(), Eq('B'));
+    ASSERT_THAT(text[1].unicode(), Eq(' '));
+}
+
+TEST_F(ATerminalDisplayBuffer, translatesWholeBufferToUnicode)
+{
+    const unsigned char run[]{0xc1, 0x20, 0xc2};
+    const EbcdicCodec *codec = EbcdicCodec::codecForCcsid(500);
+    std::vector<QChar> text(80 * 25);
+    displayBuffer->setBufferAddress(79, 1);
+    displayBuffer->writeRun(run, 3);
+
+    displayBuffer->toUnicode(codec, text.data());
+
+    ASSERT_THAT(text[78].unicode(), Eq('A'));
+    ASSERT_THAT(text[79].unicode(), Eq(' '));
+    ASSERT_THAT(text[80].unicode(), Eq('B'));
+    ASSERT_THAT(text[80 * 25 - 1].unicode(), Eq(' '));
+}
+
+TEST_F(ATerminalDisplayBuffer, damagesEveryRowOnSetSize)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+
+    displayBuffer->setSize(80, 24);
+
+    ASSERT_TRUE(displayBuffer->damagedColumns(24, firstColumn, lastColumn));
+    ASSERT_THAT(firstColumn, Eq(1));
+    ASSERT_THAT(lastColumn, Eq(80));
+}
+
+TEST_F(ATerminalDisplayBuffer, hasNoDamageAfterClearDamage)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+
+    displayBuffer->clearDamage();
+
+    ASSERT_FALSE(displayBuffer->damagedColumns(1, firstColumn, lastColumn));
+}
+
+TEST_F(ATerminalDisplayBuffer, damagesOnlyChangedCell)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->clearDamage();
+
+    displayBuffer->setCharacterAt(5, 3, ArbitraryCharacter);
+
+    ASSERT_FALSE(displayBuffer->damagedColumns(2, firstColumn, lastColumn));
+    ASSERT_TRUE(displayBuffer->damagedColumns(3, firstColumn, lastColumn));
+    ASSERT_THAT(firstColumn, Eq(5));
+    ASSERT_THAT(lastColumn, Eq(5));
+}
+
+TEST_F(ATerminalDisplayBuffer, mergesDamagedCellsOfRow)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->clearDamage();
+
+    displayBuffer->setCharacterAt(9, 3, ArbitraryCharacter);
+    displayBuffer->setCharacterAt(5, 3, ArbitraryCharacter);
+
+    displayBuffer->damagedColumns(3, firstColumn, lastColumn);
+    ASSERT_THAT(firstColumn, Eq(5));
+    ASSERT_THAT(lastColumn, Eq(9));
+}
+
+TEST_F(ATerminalDisplayBuffer, doesNotDamageCellWrittenWithSameCharacter)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->setCharacterAt(5, 3, ArbitraryCharacter);
+    displayBuffer->clearDamage();
+
+    displayBuffer->setCharacterAt(5, 3, ArbitraryCharacter);
+
+    ASSERT_FALSE(displayBuffer->damagedColumns(3, firstColumn, lastColumn));
+}
+
+TEST_F(ATerminalDisplayBuffer, damagesRestOfRowOnWritingAttribute)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->clearDamage();
+
+    displayBuffer->setCharacterAt(5, 3, UnderlineAttribute);
+
+    displayBuffer->damagedColumns(3, firstColumn, lastColumn);
+    ASSERT_THAT(firstColumn, Eq(5));
+    ASSERT_THAT(lastColumn, Eq(80));
+}
+
+TEST_F(ATerminalDisplayBuffer, damagesRowsOfRunUpToEndOfLastRow)
+{
+    const std::vector<unsigned char> run(100, ArbitraryCharacter);
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->clearDamage();
+    displayBuffer->setBufferAddress(41, 2);
+
+    displayBuffer->writeRun(run.data(), run.size());
+
+    displayBuffer->damagedColumns(2, firstColumn, lastColumn);
+    ASSERT_THAT(firstColumn, Eq(41));
+    displayBuffer->damagedColumns(3, firstColumn, lastColumn);
+    ASSERT_THAT(firstColumn, Eq(1));
+    ASSERT_THAT(lastColumn, Eq(80));
+    ASSERT_FALSE(displayBuffer->damagedColumns(4, firstColumn, lastColumn));
+}
+
+TEST_F(ATerminalDisplayBuffer, doesNotDamageRowsOfUnchangedRun)
+{
+    const std::vector<unsigned char> run(10, ArbitraryCharacter);
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->writeRun(run.data(), run.size());
+    displayBuffer->clearDamage();
+    displayBuffer->setBufferAddress(1, 1);
+
+    displayBuffer->writeRun(run.data(), run.size());
+
+    ASSERT_FALSE(displayBuffer->damagedColumns(1, firstColumn, lastColumn));
+}
+
+TEST_F(ATerminalDisplayBuffer, damagesRowsOfRepeatedCharacter)
+{
+    unsigned char firstColumn = 0;
+    unsigned char lastColumn = 0;
+    displayBuffer->clearDamage();
+    displayBuffer->setBufferAddress(10, 2);
+
+    displayBuffer->repeatCharacterToAddress(20, 3, ArbitraryCharacter);
+
+    ASSERT_FALSE(displayBuffer->damagedColumns(1, firstColumn, lastColumn));
+    displayBuffer->damagedColumns(2, firstColumn, lastColumn);
+    ASSERT_THAT(firstColumn, Eq(10));
+    ASSERT_TRUE(displayBuffer->damagedColumns(3, firstColumn, lastColumn));
+}
+
 TEST_F(ATerminalDisplayBuffer, writesAttributesOfOutputField)
 {
     const unsigned short fieldLength = 5;
@@ -27,6 +27,7 @@
 using namespace testing;
 
 #include <QByteArray>
+#include <QLoggingCategory>
 #include <QSignalSpy>
 #include <QTextCodec>
 
@@ -34,40 +35,67 @@ using namespace testing;
 #include <terminal/field.h>
 #include <terminal/formattable.h>
 #include <terminal/terminaldisplay.h>
+#include <terminal/terminaldisplaybuffer.h>
 #include <terminal/terminalemulator.h>
+#include <terminal/terminalformattable.h>
+#include "allocationcounter.h"
 using namespace q5250;
 
 class DisplayBufferMock : public DisplayBuffer
 {
 public:
+    DisplayBufferMock()
+    {
+        static const unsigned char BlankRow[255] = {};
+        ON_CALL(*this, rowCells(_)).WillByDefault(Return(BlankRow));
+    }
+
     MOCK_CONST_METHOD0(size, QSize());
     MOCK_METHOD2(setSize, void(unsigned char, unsigned char));
     MOCK_CONST_METHOD0(bufferColumn, unsigned char());
     MOCK_CONST_METHOD0(bufferRow, unsigned char());;
     MOCK_METHOD2(setBufferAddress, void(unsigned char, unsigned char));
     MOCK_CONST_METHOD2(characterAt, unsigned char(unsigned char, unsigned char));
+    MOCK_CONST_METHOD1(rowCells, const unsigned char*(unsigned char));
     MOCK_METHOD1(setCharacter, void(unsigned char));
+    MOCK_METHOD2(writeRun, void(const unsigned char*, size_t));
     MOCK_METHOD2(setCharacterAt, void(unsigned char, unsigned char));
     MOCK_METHOD3(setCharacterAt, void(unsigned char, unsigned char, unsigned char));
     MOCK_METHOD3(repeatCharacterToAddress, void(unsigned char, unsigned char, unsigned char));
     MOCK_METHOD1(addField, void(q5250::Field*));
     MOCK_CONST_METHOD1(fieldContent, QByteArray(const q5250::Field *));
+    MOCK_CONST_METHOD3(damagedColumns, bool(unsigned char, unsigned char &, unsigned char &));
+    MOCK_METHOD0(clearDamage, void());
 };
 
 class FormatTableMock : public FormatTable
 {
 public:
+    FormatTableMock()
+    {
+        ON_CALL(*this, fieldAt(_, _)).WillByDefault(Return(int(NoField)));
+        ON_CALL(*this, nextInputField(_)).WillByDefault(Return(int(NoField)));
+        ON_CALL(*this, previousInputField(_)).WillByDefault(Return(int(NoField)));
+    }
+
     MOCK_METHOD0(clear, void());
-    MOCK_METHOD1(append, void(q5250::Field*));
-    MOCK_CONST_METHOD2(fieldAt, q5250::Field*(const Cursor &, int));
+    MOCK_METHOD1(append, int(const q5250::Field &));
+    MOCK_METHOD1(field, q5250::Field&(int));
+    MOCK_CONST_METHOD2(fieldAt, int(const Cursor &, int));
+    MOCK_CONST_METHOD1(nextInputField, int(const Cursor &));
+    MOCK_CONST_METHOD1(previousInputField, int(const Cursor &));
+    MOCK_METHOD1(markAsModified, void(int));
+    MOCK_CONST_METHOD0(isModified, bool());
     MOCK_CONST_METHOD0(isEmpty, bool());
-    MOCK_CONST_METHOD1(map, void(std::function<void (q5250::Field*)> func));
+    MOCK_CONST_METHOD1(map, void(std::function<void (const q5250::Field &)> func));
+    MOCK_CONST_METHOD1(mapModified, void(std::function<void (const q5250::Field &)> func));
 };
 
 class TerminalDisplayMock : public TerminalDisplay
 {
 public:
     MOCK_METHOD0(clear, void());
+    MOCK_METHOD4(clearArea, void(unsigned char, unsigned char, unsigned char, unsigned char));
     MOCK_METHOD3(displayText, void(unsigned char, unsigned char, const QString&));
     MOCK_METHOD1(displayAttribute, void(unsigned char));
     MOCK_METHOD2(displayCursor, void(unsigned char, unsigned char));
@@ -85,10 +113,17 @@ public:
     static const char ClearUnitCommand = 0x40;
     static const char WriteToDisplayCommand = 0x11;
     static const char WriteStructuredFieldCommand = 0xf3;
+    static const char ReadInputFieldsCommand = 0x42;
+    static const char ReadImmediateCommand = 0x72;
 
     static const char StartOfHeaderOrder = 0x01;
     static const char RepeatToAddressOrder = 0x02;
+    static const char EraseToAddressOrder = 0x03;
+    static const char TransparentDataOrder = 0x10;
     static const char SetBufferAddressOrder = 0x11;
+    static const char WriteExtendedAttributeOrder = 0x12;
+    static const char InsertCursorOrder = 0x13;
+    static const char MoveCursorOrder = 0x14;
     static const char StartOfFieldOrder = 0x1d;
 
     static const char GreenAttribute = 0x20;
@@ -152,6 +187,30 @@ public:
 };
 
 static const QString ArbitraryText{"ABC"};
+static const int ArbitraryFieldId = 3;
+
+MATCHER_P(PointsToRun, run, "")
+{
+    return memcmp(arg, run.constData(), run.size()) == 0;
+}
+
+static QByteArray runOf(const char *data, int size)
+{
+    return QByteArray(data, size);
+}
+
+// a row of width NUL cells with cells written from column on
+static QByteArray rowOf(int width, int column, const QByteArray &cells)
+{
+    QByteArray row(width, '\0');
+    row.replace(column - 1, cells.size(), cells);
+    return row;
+}
+
+static const unsigned char *cellsOf(const QByteArray &row)
+{
+    return reinterpret_cast<const unsigned char*>(row.constData());
+}
 
 namespace q5250 {
 
@@ -181,6 +240,64 @@ TEST_F(ATerminalEmulator, callsUpdateAfterParsingReceivedData)
     terminal.dataReceived(QByteArray());
 }
 
+TEST_F(ATerminalEmulator, coalescesUpdatesOfReceivedDataWithinFrameInterval)
+{
+    const char clearUnitCommand[]{ESC, ClearUnitCommand};
+    const QByteArray data = createGdsHeaderWithLength(2) + QByteArray::fromRawData(clearUnitCommand, 2);
+    terminal.setFrameInterval(16);
+
+    EXPECT_CALL(terminalDisplay, clear()).Times(0);
+
+    terminal.dataReceived(data);
+    terminal.dataReceived(data);
+}
+
+TEST_F(ATerminalEmulator, updatesAtOnceWhenReceivedDataUnlocksKeyboard)
+{
+    const char writeToDisplayCommand[]{ESC, WriteToDisplayCommand, 0x00, 0x08};
+    const QByteArray data = createGdsHeaderWithLength(4) + QByteArray::fromRawData(writeToDisplayCommand, 4);
+    terminal.setFrameInterval(16);
+
+    EXPECT_CALL(terminalDisplay, clear()).Times(1);
+
+    terminal.dataReceived(data);
+}
+
+TEST_F(ATerminalEmulator, updatesAtOnceWhenReadCommandWaitsForInput)
+{
+    const char readInputFieldsCommand[]{ESC, ReadInputFieldsCommand, 0x00, 0x00};
+    const QByteArray data = createGdsHeaderWithLength(4) + QByteArray::fromRawData(readInputFieldsCommand, 4);
+    terminal.setFrameInterval(16);
+
+    EXPECT_CALL(terminalDisplay, clear()).Times(1);
+
+    terminal.dataReceived(data);
+}
+
+TEST_F(ATerminalEmulator, parsesRecordSplitAcrossReceivedData)
+{
+    const char clearUnitCommand[]{ESC, ClearUnitCommand};
+    const QByteArray data = createGdsHeaderWithLength(2) + QByteArray::fromRawData(clearUnitCommand, 2);
+    EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(0, 0)));
+
+    EXPECT_CALL(displayBuffer, setSize(80, 25)).Times(1);
+
+    terminal.dataReceived(data.left(5));
+    terminal.dataReceived(data.mid(5));
+}
+
+TEST_F(ATerminalEmulator, ignoresReceivedDataWithMalformedGdsHeader)
+{
+    const char clearUnitCommand[]{ESC, ClearUnitCommand};
+    QByteArray data = createGdsHeaderWithLength(2) + QByteArray::fromRawData(clearUnitCommand, 2);
+    data[1] = 0x04;
+    EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(0, 0)));
+
+    EXPECT_CALL(displayBuffer, setSize(_, _)).Times(0);
+
+    terminal.dataReceived(data);
+}
+
 TEST_F(ATerminalEmulator, handlesMultipleCommandsInReceivedData)
 {
     const char writeToDisplayCommand[]{ESC, WriteToDisplayCommand, 0x00, 0x18, 'A'};
@@ -189,7 +306,7 @@ TEST_F(ATerminalEmulator, handlesMultipleCommandsInReceivedData)
                           + QByteArray::fromRawData(writeToDisplayCommand, 5)
                           + QByteArray::fromRawData(clearUnitCommand, 2);
 
-    EXPECT_CALL(displayBuffer, setCharacter('A'));
+    EXPECT_CALL(displayBuffer, writeRun(PointsToRun(runOf("A", 1)), 1));
     EXPECT_CALL(displayBuffer, setSize(80, 25));
 
     terminal.parseStreamData(data);
@@ -232,9 +349,8 @@ TEST_F(ATerminalEmulator, writesCharactersToDisplayBuffer)
     const QByteArray ebcdicText = textAsEbcdic(ArbitraryText);
     const QByteArray data = createWriteToDisplayCommandWithOrderLength(ebcdicText.length()) + ebcdicText;
 
-    EXPECT_CALL(displayBuffer, setCharacter(ebcdicText.at(0)));
-    EXPECT_CALL(displayBuffer, setCharacter(ebcdicText.at(1)));
-    EXPECT_CALL(displayBuffer, setCharacter(ebcdicText.at(2)));
+    EXPECT_CALL(displayBuffer, writeRun(PointsToRun(ebcdicText), ebcdicText.size()));
+    EXPECT_CALL(displayBuffer, setCharacter(_)).Times(0);
 
     terminal.parseStreamData(data);
 }
@@ -244,8 +360,7 @@ TEST_F(ATerminalEmulator, writesAttributesToDisplayBuffer)
     const char attributeData[]{GreenAttribute, NonDisplay4Attribute};
     const QByteArray data = createWriteToDisplayCommandWithOrderLength(2) + QByteArray::fromRawData(attributeData, 2);
 
-    EXPECT_CALL(displayBuffer, setCharacter(GreenAttribute));
-    EXPECT_CALL(displayBuffer, setCharacter(NonDisplay4Attribute));
+    EXPECT_CALL(displayBuffer, writeRun(PointsToRun(runOf(attributeData, 2)), 2));
 
     terminal.parseStreamData(data);
 }
@@ -266,6 +381,67 @@ TEST_F(ATerminalEmulator, repeatsCharactersToReceivedAddress)
     terminal.parseStreamData(data);
 }
 
+TEST_F(ATerminalEmulator, erasesToReceivedAddress)
+{
+    const char endRow = 5;
+    const char endColumn = 4;
+    const char streamData[]{EraseToAddressOrder, endRow, endColumn, 0x02, (char)0xff};
+    const QByteArray data = createWriteToDisplayCommandWithOrderLength(5) + QByteArray::fromRawData(streamData, 5);
+
+    EXPECT_CALL(displayBuffer, repeatCharacterToAddress(endColumn, endRow, '\0'));
+    EXPECT_CALL(displayBuffer, writeRun(_, _)).Times(0);
+
+    terminal.parseStreamData(data);
+}
+
+TEST_F(ATerminalEmulator, writesTransparentDataWithoutInterpretingOrders)
+{
+    const char streamData[]{TransparentDataOrder, 0x00, 0x02, SetBufferAddressOrder, ESC, 'A'};
+    const QByteArray data = createWriteToDisplayCommandWithOrderLength(6) + QByteArray::fromRawData(streamData, 6);
+
+    EXPECT_CALL(displayBuffer, writeRun(PointsToRun(runOf(streamData + 3, 2)), 2));
+    EXPECT_CALL(displayBuffer, writeRun(PointsToRun(runOf("A", 1)), 1));
+    EXPECT_CALL(displayBuffer, setBufferAddress(_, _)).Times(0);
+
+    terminal.parseStreamData(data);
+}
+
+TEST_F(ATerminalEmulator, skipsWriteExtendedAttribute)
+{
+    const char streamData[]{WriteExtendedAttributeOrder, 0x01, 0x20, 'A'};
+    const QByteArray data = createWriteToDisplayCommandWithOrderLength(4) + QByteArray::fromRawData(streamData, 4);
+
+    EXPECT_CALL(displayBuffer, writeRun(PointsToRun(runOf("A", 1)), 1));
+
+    terminal.parseStreamData(data);
+}
+
+TEST_F(ATerminalEmulator, movesCursorToReceivedAddress)
+{
+    const char row = 5;
+    const char column = 10;
+    const char streamData[]{MoveCursorOrder, row, column};
+    const QByteArray data = createWriteToDisplayCommandWithOrderLength(3) + QByteArray::fromRawData(streamData, 3);
+
+    terminal.parseStreamData(data);
+
+    ASSERT_THAT(terminal.cursorPosition().column(), Eq(column));
+    ASSERT_THAT(terminal.cursorPosition().row(), Eq(row));
+}
+
+TEST_F(ATerminalEmulator, setsCursorToInsertCursorAddress)
+{
+    const char row = 7;
+    const char column = 2;
+    const char streamData[]{InsertCursorOrder, row, column};
+    const QByteArray data = createWriteToDisplayCommandWithOrderLength(3) + QByteArray::fromRawData(streamData, 3);
+
+    terminal.parseStreamData(data);
+
+    ASSERT_THAT(terminal.cursorPosition().column(), Eq(column));
+    ASSERT_THAT(terminal.cursorPosition().row(), Eq(row));
+}
+
 TEST_F(ATerminalEmulator, drawsMultipleTextInBufferOnDisplay)
 {
     const QByteArray ebcdicText = textAsEbcdic(ArbitraryText);
@@ -275,14 +451,12 @@ TEST_F(ATerminalEmulator, drawsMultipleTextInBufferOnDisplay)
     const QString firstLine = QString("%1%2").arg(ArbitraryText).arg(' ', 77);
     const QString secondLine = QString("%1%2").arg(' ', 77).arg("DEF");
 
+    const QByteArray firstRow = rowOf(80, 1, ebcdicText);
+    const QByteArray secondRow = rowOf(80, startColumn, ebcdicText2);
+
     EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(80, 2)));
-    EXPECT_CALL(displayBuffer, characterAt(_, _)).WillRepeatedly(Return(0x00));
-    EXPECT_CALL(displayBuffer, characterAt(1, 1)).WillOnce(Return(ebcdicText.at(0)));
-    EXPECT_CALL(displayBuffer, characterAt(2, 1)).WillOnce(Return(ebcdicText.at(1)));
-    EXPECT_CALL(displayBuffer, characterAt(3, 1)).WillOnce(Return(ebcdicText.at(2)));
-    EXPECT_CALL(displayBuffer, characterAt(startColumn, startRow)).WillOnce(Return(ebcdicText2.at(0)));
-    EXPECT_CALL(displayBuffer, characterAt(startColumn+1, startRow)).WillOnce(Return(ebcdicText2.at(1)));
-    EXPECT_CALL(displayBuffer, characterAt(startColumn+2, startRow)).WillOnce(Return(ebcdicText2.at(2)));
+    EXPECT_CALL(displayBuffer, rowCells(1)).WillOnce(Return(cellsOf(firstRow)));
+    EXPECT_CALL(displayBuffer, rowCells(startRow)).WillOnce(Return(cellsOf(secondRow)));
     EXPECT_CALL(terminalDisplay, clear());
     EXPECT_CALL(terminalDisplay, displayText(1, 1, firstLine));
     EXPECT_CALL(terminalDisplay, displayText(1, startRow, secondLine));
@@ -296,13 +470,10 @@ TEST_F(ATerminalEmulator, drawsTextWithSurroundingAttributesInBufferOnDisplay)
     const QByteArray ebcdicText = textAsEbcdic(ArbitraryText);
     const QString remainingLine(5, ' ');
 
+    const QByteArray row = rowOf(10, 1, char(GreenAttribute) + ebcdicText + char(NonDisplay4Attribute));
+
     EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(10, 1)));
-    EXPECT_CALL(displayBuffer, characterAt(_, _)).WillRepeatedly(Return(0x00));
-    EXPECT_CALL(displayBuffer, characterAt(1, 1)).WillOnce(Return(GreenAttribute));
-    EXPECT_CALL(displayBuffer, characterAt(2, 1)).WillOnce(Return(ebcdicText.at(0)));
-    EXPECT_CALL(displayBuffer, characterAt(3, 1)).WillOnce(Return(ebcdicText.at(1)));
-    EXPECT_CALL(displayBuffer, characterAt(4, 1)).WillOnce(Return(ebcdicText.at(2)));
-    EXPECT_CALL(displayBuffer, characterAt(5, 1)).WillOnce(Return(NonDisplay4Attribute));
+    EXPECT_CALL(displayBuffer, rowCells(1)).WillOnce(Return(cellsOf(row)));
     EXPECT_CALL(terminalDisplay, clear());
     EXPECT_CALL(terminalDisplay, displayAttribute(GreenAttribute));
     EXPECT_CALL(terminalDisplay, displayText(2, 1, ArbitraryText));
@@ -370,7 +541,7 @@ TEST_F(ATerminalEmulator, addsInputFieldWithoutControlWordsToFormatTable)
     q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = fieldLength,
                                 .startColumn = 0, .startRow = 0 };
 
-    EXPECT_CALL(formatTable, append(Pointee(inputField)));
+    EXPECT_CALL(formatTable, append(inputField));
 
     terminal.parseStreamData(data);
 }
@@ -390,17 +561,21 @@ TEST_F(ATerminalEmulator, modifiesExistingInputField)
         EXPECT_CALL(displayBuffer, setCharacter(GreenUnderlineAttribute));
         EXPECT_CALL(displayBuffer, bufferColumn());
         EXPECT_CALL(displayBuffer, bufferRow());
-        EXPECT_CALL(formatTable, fieldAt(_, _)).WillOnce(ReturnNull());
+        EXPECT_CALL(formatTable, fieldAt(_, _)).WillOnce(Return(int(FormatTable::NoField)));
         EXPECT_CALL(displayBuffer, setCharacterAt(fieldLength, GreenAttribute));
-        EXPECT_CALL(formatTable, append(Pointee(inputField))).Times(1);
+        EXPECT_CALL(formatTable, append(inputField)).WillOnce(Return(ArbitraryFieldId));
 
         EXPECT_CALL(displayBuffer, setCharacter(RedUnderlineAttribute));
         EXPECT_CALL(displayBuffer, bufferColumn());
         EXPECT_CALL(displayBuffer, bufferRow());
-        EXPECT_CALL(formatTable, fieldAt(_, _)).WillOnce(Return(&inputField));
+        EXPECT_CALL(formatTable, fieldAt(_, _)).WillOnce(Return(ArbitraryFieldId));
+        EXPECT_CALL(formatTable, field(ArbitraryFieldId)).WillOnce(ReturnRef(inputField));
     }
 
     terminal.parseStreamData(data);
+
+    ASSERT_THAT(inputField.format, Eq(0x4020));
+    ASSERT_THAT(inputField.attribute, Eq(RedUnderlineAttribute));
 }
 
 TEST_F(ATerminalEmulator, emitsUpdateFinishedAfterUpdate)
@@ -410,7 +585,7 @@ TEST_F(ATerminalEmulator, emitsUpdateFinishedAfterUpdate)
     displayBuffer.setCharacter(ebcdicText.at(0));
 
     ON_CALL(displayBuffer, size()).WillByDefault(Return(QSize(1, 1)));
-    EXPECT_CALL(displayBuffer, characterAt(1, 1)).WillOnce(Return(ebcdicText.at(0)));
+    EXPECT_CALL(displayBuffer, rowCells(1)).WillOnce(Return(cellsOf(ebcdicText)));
     EXPECT_CALL(terminalDisplay, displayText(1, 1, QString("A")));
 
     terminal.update();
@@ -432,6 +607,84 @@ TEST_F(ATerminalEmulator, displaysCursorOnUpdate)
     terminal.update();
 }
 
+TEST_F(ATerminalEmulator, redrawsOnlyDamagedCellsAfterFirstUpdate)
+{
+    const QByteArray row = rowOf(10, 3, textAsEbcdic("A"));
+    ON_CALL(displayBuffer, size()).WillByDefault(Return(QSize(10, 2)));
+    terminal.update();
+
+    EXPECT_CALL(displayBuffer, damagedColumns(1, _, _)).WillOnce(Return(false));
+    EXPECT_CALL(displayBuffer, damagedColumns(2, _, _))
+            .WillOnce(DoAll(SetArgReferee<1>(3), SetArgReferee<2>(3), Return(true)));
+    EXPECT_CALL(displayBuffer, rowCells(2)).WillOnce(Return(cellsOf(row)));
+    EXPECT_CALL(terminalDisplay, clear()).Times(0);
+    EXPECT_CALL(terminalDisplay, clearArea(3, 2, 1, 1));
+    EXPECT_CALL(terminalDisplay, displayText(3, 2, QString("A")));
+
+    terminal.update();
+}
+
+TEST_F(ATerminalEmulator, redrawsDamagedCellsWithAttributeOfPrecedingCell)
+{
+    const QByteArray row = rowOf(10, 1, QByteArray(1, char(RedUnderlineAttribute)));
+    ON_CALL(displayBuffer, size()).WillByDefault(Return(QSize(10, 1)));
+    terminal.update();
+
+    EXPECT_CALL(displayBuffer, damagedColumns(1, _, _))
+            .WillOnce(DoAll(SetArgReferee<1>(3), SetArgReferee<2>(3), Return(true)));
+    EXPECT_CALL(displayBuffer, rowCells(1)).WillOnce(Return(cellsOf(row)));
+    EXPECT_CALL(terminalDisplay, displayAttribute(RedUnderlineAttribute));
+
+    terminal.update();
+}
+
+TEST_F(ATerminalEmulator, redrawsFollowingRowAfterAttributeChangedAtEndOfRow)
+{
+    const QByteArray row = rowOf(4, 2, QByteArray(1, char(GreenUnderlineAttribute)));
+    const QByteArray followingRow(4, '\0');
+    ON_CALL(displayBuffer, size()).WillByDefault(Return(QSize(4, 2)));
+    terminal.update();
+
+    EXPECT_CALL(displayBuffer, damagedColumns(1, _, _))
+            .WillOnce(DoAll(SetArgReferee<1>(2), SetArgReferee<2>(4), Return(true)));
+    EXPECT_CALL(displayBuffer, rowCells(1)).WillOnce(Return(cellsOf(row)));
+    EXPECT_CALL(displayBuffer, damagedColumns(2, _, _)).Times(0);
+    EXPECT_CALL(displayBuffer, rowCells(2)).WillOnce(Return(cellsOf(followingRow)));
+    EXPECT_CALL(terminalDisplay, clearArea(2, 1, 3, 1));
+    EXPECT_CALL(terminalDisplay, clearArea(1, 2, 4, 1));
+
+    terminal.update();
+}
+
+TEST_F(ATerminalEmulator, redrawsCellsUnderOldAndNewCursor)
+{
+    ON_CALL(displayBuffer, size()).WillByDefault(Return(QSize(10, 2)));
+    terminal.update();
+    terminal.handleKeypress(Qt::Key_Down, QString());
+
+    EXPECT_CALL(terminalDisplay, clearArea(1, 1, 1, 1));
+    EXPECT_CALL(terminalDisplay, clearArea(1, 2, 1, 1));
+    EXPECT_CALL(terminalDisplay, displayCursor(1, 2));
+
+    terminal.update();
+}
+
+TEST_F(ATerminalEmulator, clearsWholeDisplayOnRedraw)
+{
+    terminal.update();
+
+    EXPECT_CALL(terminalDisplay, clear());
+
+    terminal.redraw();
+}
+
+TEST_F(ATerminalEmulator, clearsDamageOfDisplayBufferOnUpdate)
+{
+    EXPECT_CALL(displayBuffer, clearDamage());
+
+    terminal.update();
+}
+
 TEST_F(ATerminalEmulator, callsUpdateAfterHandlingKeypress)
 {
     EXPECT_CALL(displayBuffer, size()).Times(2).WillRepeatedly(Return(QSize(0, 0)));
@@ -452,12 +705,38 @@ TEST_F(ATerminalEmulator, addsPressedTextKeyToDisplayBufferIfCursorInsideField)
     const QByteArray ebcdicText = textAsEbcdic(arbitraryTextKey);
 
     EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(20, 20)));
-    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(Return(&inputField));
+    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(Return(ArbitraryFieldId));
+    EXPECT_CALL(formatTable, field(ArbitraryFieldId)).WillRepeatedly(ReturnRef(inputField));
     EXPECT_CALL(displayBuffer, setCharacterAt(cursor.column(), cursor.row(), ebcdicText.at(0)));
+    EXPECT_CALL(formatTable, markAsModified(ArbitraryFieldId));
 
     terminal.handleKeypress(Qt::Key_A, arbitraryTextKey);
 }
 
+TEST_F(ATerminalEmulator, translatesPressedTextKeyWithSelectedCcsid)
+{
+    const unsigned char column = 5;
+    const unsigned char row = 5;
+    moveCursorTo(column, row);
+    Cursor cursor(column, row);
+    q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = 10, .startColumn = column, .startRow = row };
+    ASSERT_TRUE(terminal.setCcsid(37));
+
+    EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(20, 20)));
+    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(Return(ArbitraryFieldId));
+    EXPECT_CALL(formatTable, field(ArbitraryFieldId)).WillRepeatedly(ReturnRef(inputField));
+    EXPECT_CALL(displayBuffer, setCharacterAt(cursor.column(), cursor.row(), 0xba));
+
+    terminal.handleKeypress(Qt::Key_A, QStringLiteral("["));
+}
+
+TEST_F(ATerminalEmulator, keepsCcsidOnUnsupportedCcsid)
+{
+    ASSERT_FALSE(terminal.setCcsid(1047));
+
+    ASSERT_THAT(terminal.ccsid(), Eq(500));
+}
+
 TEST_F(ATerminalEmulator, doesNotAddTextKeyToDisplayBufferIfCursorOutsideField)
 {
     const unsigned char column = 5;
@@ -467,7 +746,7 @@ TEST_F(ATerminalEmulator, doesNotAddTextKeyToDisplayBufferIfCursorOutsideField)
     const QString arbitraryTextKey("A");
 
     EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(20, 20)));
-    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(ReturnNull());
+    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(Return(int(FormatTable::NoField)));
     EXPECT_CALL(displayBuffer, setCharacterAt(_, _, _)).Times(0);
 
     terminal.handleKeypress(Qt::Key_A, arbitraryTextKey);
@@ -483,7 +762,8 @@ TEST_F(ATerminalEmulator, doesNotAddTextKeyToDisplayBufferIfFieldIsBypass)
     const QString arbitraryTextKey("A");
 
     EXPECT_CALL(displayBuffer, size()).WillRepeatedly(Return(QSize(20, 20)));
-    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(Return(&inputField));
+    EXPECT_CALL(formatTable, fieldAt(cursor, 20)).WillOnce(Return(ArbitraryFieldId));
+    EXPECT_CALL(formatTable, field(ArbitraryFieldId)).WillRepeatedly(ReturnRef(inputField));
     EXPECT_CALL(displayBuffer, setCharacterAt(_, _, _)).Times(0);
 
     terminal.handleKeypress(Qt::Key_A, arbitraryTextKey);
@@ -529,6 +809,40 @@ TEST_F(ATerminalEmulator, movesCursorRightOnKeyRight)
     ASSERT_THAT(terminal.cursorPosition().row(), Eq(1));
 }
 
+TEST_F(ATerminalEmulator, movesCursorToNextInputFieldOnKeyTab)
+{
+    q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = 10, .startColumn = 7, .startRow = 3 };
+    EXPECT_CALL(formatTable, nextInputField(_)).WillOnce(Return(ArbitraryFieldId));
+    EXPECT_CALL(formatTable, field(ArbitraryFieldId)).WillOnce(ReturnRef(inputField));
+
+    terminal.handleKeypress(Qt::Key_Tab, QString());
+
+    ASSERT_THAT(terminal.cursorPosition().column(), Eq(7));
+    ASSERT_THAT(terminal.cursorPosition().row(), Eq(3));
+}
+
+TEST_F(ATerminalEmulator, movesCursorToPreviousInputFieldOnKeyBacktab)
+{
+    q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = 10, .startColumn = 7, .startRow = 3 };
+    EXPECT_CALL(formatTable, previousInputField(_)).WillOnce(Return(ArbitraryFieldId));
+    EXPECT_CALL(formatTable, field(ArbitraryFieldId)).WillOnce(ReturnRef(inputField));
+
+    terminal.handleKeypress(Qt::Key_Backtab, QString());
+
+    ASSERT_THAT(terminal.cursorPosition().column(), Eq(7));
+    ASSERT_THAT(terminal.cursorPosition().row(), Eq(3));
+}
+
+TEST_F(ATerminalEmulator, keepsCursorOnKeyTabWithoutInputFields)
+{
+    EXPECT_CALL(formatTable, nextInputField(_)).WillOnce(Return(int(FormatTable::NoField)));
+
+    terminal.handleKeypress(Qt::Key_Tab, QString());
+
+    ASSERT_THAT(terminal.cursorPosition().column(), Eq(1));
+    ASSERT_THAT(terminal.cursorPosition().row(), Eq(1));
+}
+
 TEST_F(ATerminalEmulator, movesCursorRightAfterTextKeyPress)
 {
     const unsigned char column = 5;
@@ -536,7 +850,8 @@ TEST_F(ATerminalEmulator, movesCursorRightAfterTextKeyPress)
     moveCursorTo(column, row);
     q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = 10, .startColumn = column, .startRow = row };
     const QString arbitraryTextKey("A");
-    ON_CALL(formatTable, fieldAt(_, _)).WillByDefault(Return(&inputField));
+    ON_CALL(formatTable, fieldAt(_, _)).WillByDefault(Return(ArbitraryFieldId));
+    ON_CALL(formatTable, field(ArbitraryFieldId)).WillByDefault(ReturnRef(inputField));
 
     terminal.handleKeypress(Qt::Key_A, arbitraryTextKey);
 
@@ -566,7 +881,29 @@ TEST_F(ATerminalEmulator, sendsFieldPositionAndContentOnKeyReturn)
     const QByteArray generalDataStream = createGdsHeaderWithLength(streamLength, 0x00) + cursorAndAidBytes + fieldPosition + fieldContent;
     q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = 5,
                                 .startColumn = 10, .startRow = 5 };
-    EXPECT_CALL(formatTable, map(_)).WillOnce(InvokeArgument<0>(&inputField));
+    EXPECT_CALL(formatTable, mapModified(_)).WillOnce(InvokeArgument<0>(ByRef(inputField)));
+    EXPECT_CALL(displayBuffer, fieldContent(Pointee(inputField))).WillOnce(Return(fieldContent));
+
+    terminal.handleKeypress(Qt::Key_Return, QString());
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(generalDataStream));
+}
+
+TEST_F(ATerminalEmulator, sendsAllInputFieldsOnKeyReturnAfterReadInputFields)
+{
+    QSignalSpy spy(&terminal, SIGNAL(sendData(QByteArray)));
+    const char readInputFieldsCommand[]{ESC, ReadInputFieldsCommand, 0x00, 0x00};
+    const QByteArray fieldContent {"ABC"};
+    const QByteArray cursorAidAndContent {"\x01\x01\xf1" "ABC\x40\x40"};
+    const QByteArray generalDataStream = createGdsHeaderWithLength(cursorAidAndContent.size(), 0x00) + cursorAidAndContent;
+    q5250::Field inputField = { .format = 0x4000, .attribute = GreenUnderlineAttribute, .length = 5,
+                                .startColumn = 10, .startRow = 5 };
+    terminal.parseStreamData(createGdsHeaderWithLength(4) + QByteArray::fromRawData(readInputFieldsCommand, 4));
+
+    EXPECT_CALL(formatTable, isModified()).WillOnce(Return(true));
+    EXPECT_CALL(formatTable, map(_)).WillOnce(InvokeArgument<0>(ByRef(inputField)));
+    EXPECT_CALL(formatTable, mapModified(_)).Times(0);
     EXPECT_CALL(displayBuffer, fieldContent(Pointee(inputField))).WillOnce(Return(fieldContent));
 
     terminal.handleKeypress(Qt::Key_Return, QString());
@@ -575,6 +912,36 @@ TEST_F(ATerminalEmulator, sendsFieldPositionAndContentOnKeyReturn)
     ASSERT_THAT(spy[0][0].toByteArray(), Eq(generalDataStream));
 }
 
+TEST_F(ATerminalEmulator, sendsNoInputFieldsAfterReadInputFieldsIfNoneModified)
+{
+    QSignalSpy spy(&terminal, SIGNAL(sendData(QByteArray)));
+    const char readInputFieldsCommand[]{ESC, ReadInputFieldsCommand, 0x00, 0x00};
+    const QByteArray cursorAndAidBytes {"\x01\x01\xf1"};
+    const QByteArray generalDataStream = createGdsHeaderWithLength(cursorAndAidBytes.size(), 0x00) + cursorAndAidBytes;
+    terminal.parseStreamData(createGdsHeaderWithLength(4) + QByteArray::fromRawData(readInputFieldsCommand, 4));
+
+    EXPECT_CALL(formatTable, isModified()).WillOnce(Return(false));
+    EXPECT_CALL(formatTable, map(_)).Times(0);
+
+    terminal.handleKeypress(Qt::Key_Return, QString());
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(generalDataStream));
+}
+
+TEST_F(ATerminalEmulator, repliesWithoutAidToReadImmediate)
+{
+    QSignalSpy spy(&terminal, SIGNAL(sendData(QByteArray)));
+    const char readImmediateCommand[]{ESC, ReadImmediateCommand};
+    const QByteArray cursorAndAidBytes("\x01\x01\x00", 3);
+    const QByteArray generalDataStream = createGdsHeaderWithLength(cursorAndAidBytes.size(), 0x00) + cursorAndAidBytes;
+
+    terminal.parseStreamData(createGdsHeaderWithLength(2) + QByteArray::fromRawData(readImmediateCommand, 2));
+
+    ASSERT_THAT(spy.count(), Eq(1));
+    ASSERT_THAT(spy[0][0].toByteArray(), Eq(generalDataStream));
+}
+
 TEST_F(ATerminalEmulator, repliesTo5250QueryCommand)
 {
     QSignalSpy spy(&terminal, SIGNAL(sendData(QByteArray)));
@@ -622,3 +989,69 @@ TEST_F(ATerminalEmulator, repliesTo5250QueryCommand)
     ASSERT_THAT(spy.count(), Eq(1));
     ASSERT_THAT(spy[0][0].toByteArray(), Eq(createGeneralDataStream(QByteArray::fromRawData(queryResponse, 71))));
 }
+
+class ATerminalEmulatorWithDisplayBuffer : public Test
+{
+public:
+    TerminalEmulator terminal;
+    TerminalDisplayBuffer displayBuffer;
+    TerminalFormatTable formatTable;
+
+    ATerminalEmulatorWithDisplayBuffer()
+    {
+        terminal.setDisplayBuffer(&displayBuffer);
+        terminal.setFormatTable(&formatTable);
+        QLoggingCategory::setFilterRules(QStringLiteral("q5250.*.debug=false"));
+    }
+
+    ~ATerminalEmulatorWithDisplayBuffer()
+    {
+        QLoggingCategory::setFilterRules(QString());
+    }
+
+    // WRITE TO DISPLAY with an input field and data on every row
+    QByteArray createFullScreenRecord()
+    {
+        QByteArray record("\x00\x00\x12\xa0\x00\x00\x04\x00\x00\x03", 10);
+        record.append("\x04\x11\x00\x18", 4);
+        record.append("\x01\x00", 2);
+
+        for (char row = 1; row <= 24; ++row) {
+            record.append('\x11').append(row).append('\x01');
+            record.append("\x1d\x40\x00\x24\x00\x0a", 6);
+            record.append("\xc1\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xd1", 10);
+        }
+
+        record[0] = char(record.size() >> 8);
+        record[1] = char(record.size());
+        return record;
+    }
+};
+
+TEST_F(ATerminalEmulatorWithDisplayBuffer, makesNoHeapAllocationsForRepeatedRecords)
+{
+    const QByteArray record = createFullScreenRecord();
+    terminal.parseStreamData(record);
+
+    AllocationCounter counter;
+    terminal.parseStreamData(record);
+
+    ASSERT_THAT(counter.allocations(), Eq(0));
+}
+
+TEST_F(ATerminalEmulatorWithDisplayBuffer, sendsOnlyModifiedFieldsOnKeyReturn)
+{
+    QSignalSpy spy(&terminal, SIGNAL(sendData(QByteArray)));
+    const QByteArray readMdtFieldsCommand("\x04\x52\x00\x00", 4);
+    terminal.parseStreamData(createFullScreenRecord());
+    terminal.parseStreamData(QByteArray("\x00\x0e\x12\xa0\x00\x00\x04\x00\x00\x03", 10) + readMdtFieldsCommand);
+
+    terminal.handleKeypress(Qt::Key_Tab, QString());
+    terminal.handleKeypress(Qt::Key_Tab, QString());
+    terminal.handleKeypress(Qt::Key_A, QStringLiteral("Z"));
+    terminal.handleKeypress(Qt::Key_Return, QString());
+
+    const QByteArray reply = spy[0][0].toByteArray();
+    ASSERT_THAT(reply.mid(10, 3), Eq(QByteArray("\x02\x03\xf1")));
+    ASSERT_THAT(reply.mid(13), Eq(QByteArray("\x11\x02\x02\xe9\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xd1")));
+}
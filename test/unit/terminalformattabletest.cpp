@@ -29,6 +29,7 @@ using namespace testing;
 #include <terminal/cursor.h>
 #include <terminal/field.h>
 #include <terminal/terminalformattable.h>
+#include "allocationcounter.h"
 using namespace q5250;
 
 class ATerminalFormatTable : public Test
@@ -37,6 +38,7 @@ public:
     TerminalFormatTable formatTable;
 
     const unsigned int ArbitraryDisplayWidth = 80;
+    const int NoField = FormatTable::NoField;
 };
 
 TEST_F(ATerminalFormatTable, isEmptyAfterClear)
@@ -50,26 +52,26 @@ TEST_F(ATerminalFormatTable, isNotEmptyAfterFieldAppended)
 {
     q5250::Field field;
 
-    formatTable.append(&field);
+    formatTable.append(field);
 
     ASSERT_FALSE(formatTable.isEmpty());
 }
 
-TEST_F(ATerminalFormatTable, returnsNullForFieldAtIfEmpty)
+TEST_F(ATerminalFormatTable, returnsNoFieldForFieldAtIfEmpty)
 {
     Cursor cursor;
     formatTable.clear();
 
-    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), IsNull());
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(NoField));
 }
 
-TEST_F(ATerminalFormatTable, returnsNullForFieldAtIfCursorNotInside)
+TEST_F(ATerminalFormatTable, returnsNoFieldForFieldAtIfCursorNotInside)
 {
     Cursor cursor;
     q5250::Field field = { .format = 0x0000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
-    formatTable.append(&field);
+    formatTable.append(field);
 
-    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), IsNull());
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(NoField));
 }
 
 TEST_F(ATerminalFormatTable, returnsFieldAtCursorPosition)
@@ -78,21 +80,253 @@ TEST_F(ATerminalFormatTable, returnsFieldAtCursorPosition)
     const unsigned char row = 5;
     Cursor cursor; cursor.setPosition(column, row);
     q5250::Field field = { .format = 0x0000, .attribute = 0x00, .length = 1, .startColumn = column, .startRow = row };
-    formatTable.append(&field);
+    formatTable.append(field);
 
-    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(&field));
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(0));
+}
+
+TEST_F(ATerminalFormatTable, returnsFieldAtCursorPositionInsideField)
+{
+    Cursor cursor; cursor.setPosition(8, 5);
+    q5250::Field field = { .format = 0x0000, .attribute = 0x00, .length = 10, .startColumn = 5, .startRow = 5 };
+    formatTable.append(field);
+
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(0));
+}
+
+TEST_F(ATerminalFormatTable, returnsFieldAppendedAfterFirstLookup)
+{
+    Cursor cursor; cursor.setPosition(5, 7);
+    q5250::Field field1 = { .format = 0x0000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x0000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 7 };
+    formatTable.append(field1);
+    formatTable.fieldAt(cursor, ArbitraryDisplayWidth);
+
+    formatTable.append(field2);
+
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(1));
+}
+
+TEST_F(ATerminalFormatTable, returnsNoFieldForFieldAtAfterClear)
+{
+    Cursor cursor; cursor.setPosition(5, 5);
+    q5250::Field field = { .format = 0x0000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    formatTable.append(field);
+    formatTable.fieldAt(cursor, ArbitraryDisplayWidth);
+
+    formatTable.clear();
+
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(NoField));
+}
+
+TEST_F(ATerminalFormatTable, returnsFieldAppendedFirstForOverlappingFields)
+{
+    Cursor cursor; cursor.setPosition(6, 5);
+    q5250::Field field1 = { .format = 0x0000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x0000, .attribute = 0x00, .length = 5, .startColumn = 6, .startRow = 5 };
+    formatTable.append(field1);
+    formatTable.append(field2);
+
+    ASSERT_THAT(formatTable.fieldAt(cursor, ArbitraryDisplayWidth), Eq(0));
+}
+
+TEST_F(ATerminalFormatTable, returnsNextInputFieldAfterCursor)
+{
+    Cursor cursor; cursor.setPosition(6, 5);
+    q5250::Field field1 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 7 };
+    formatTable.append(field2);
+    formatTable.append(field1);
+
+    ASSERT_THAT(formatTable.nextInputField(cursor), Eq(0));
+}
+
+TEST_F(ATerminalFormatTable, wrapsNextInputFieldToFirstField)
+{
+    Cursor cursor; cursor.setPosition(6, 7);
+    q5250::Field field1 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 7 };
+    formatTable.append(field1);
+    formatTable.append(field2);
+
+    ASSERT_THAT(formatTable.nextInputField(cursor), Eq(0));
+}
+
+TEST_F(ATerminalFormatTable, skipsOutputAndBypassFieldsForNextInputField)
+{
+    Cursor cursor; cursor.setPosition(1, 1);
+    q5250::Field outputField = { .format = 0x0000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 3 };
+    q5250::Field bypassField = { .format = 0x6000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 5 };
+    q5250::Field inputField = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 7 };
+    formatTable.append(outputField);
+    formatTable.append(bypassField);
+    formatTable.append(inputField);
+
+    ASSERT_THAT(formatTable.nextInputField(cursor), Eq(2));
+}
+
+TEST_F(ATerminalFormatTable, returnsPreviousInputFieldBeforeCursor)
+{
+    Cursor cursor; cursor.setPosition(5, 7);
+    q5250::Field field1 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 7 };
+    formatTable.append(field1);
+    formatTable.append(field2);
+
+    ASSERT_THAT(formatTable.previousInputField(cursor), Eq(0));
+}
+
+TEST_F(ATerminalFormatTable, wrapsPreviousInputFieldToLastField)
+{
+    Cursor cursor; cursor.setPosition(5, 5);
+    q5250::Field field1 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x4000, .attribute = 0x00, .length = 5, .startColumn = 5, .startRow = 7 };
+    formatTable.append(field1);
+    formatTable.append(field2);
+
+    ASSERT_THAT(formatTable.previousInputField(cursor), Eq(1));
+}
+
+TEST_F(ATerminalFormatTable, returnsNoFieldForNextInputFieldIfEmpty)
+{
+    Cursor cursor;
+
+    ASSERT_THAT(formatTable.nextInputField(cursor), Eq(NoField));
 }
 
 TEST_F(ATerminalFormatTable, appliesPassedFunctionToEachElementOfFieldList)
 {
     unsigned count = 0;
     q5250::Field field1, field2;
-    formatTable.append(&field1);
-    formatTable.append(&field2);
+    formatTable.append(field1);
+    formatTable.append(field2);
 
-    formatTable.map([&](q5250::Field *field) {
+    formatTable.map([&](const q5250::Field &field) {
         ++count;
     });
 
     ASSERT_THAT(count, Eq(2));
 }
+
+TEST_F(ATerminalFormatTable, returnsIdOfAppendedField)
+{
+    q5250::Field field1, field2;
+    formatTable.append(field1);
+
+    ASSERT_THAT(formatTable.append(field2), Eq(1));
+}
+
+TEST_F(ATerminalFormatTable, storesCopyOfAppendedField)
+{
+    q5250::Field field = { .format = 0x0000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    int fieldId = formatTable.append(field);
+
+    field.length = 2;
+
+    ASSERT_THAT(formatTable.field(fieldId).length, Eq(1));
+}
+
+TEST_F(ATerminalFormatTable, modifiesStoredFieldThroughId)
+{
+    q5250::Field field = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    int fieldId = formatTable.append(field);
+
+    formatTable.field(fieldId).markAsModified();
+
+    ASSERT_TRUE(formatTable.field(fieldId).isModified());
+}
+
+TEST_F(ATerminalFormatTable, isNotModifiedWithoutModifiedField)
+{
+    q5250::Field field = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    formatTable.append(field);
+
+    ASSERT_FALSE(formatTable.isModified());
+}
+
+TEST_F(ATerminalFormatTable, isModifiedAfterFieldMarkedAsModified)
+{
+    q5250::Field field = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    int fieldId = formatTable.append(field);
+
+    formatTable.markAsModified(fieldId);
+
+    ASSERT_TRUE(formatTable.isModified());
+    ASSERT_TRUE(formatTable.field(fieldId).isModified());
+}
+
+TEST_F(ATerminalFormatTable, appliesPassedFunctionOnlyToModifiedFieldsInFieldOrder)
+{
+    std::vector<unsigned char> rows;
+    q5250::Field field1 = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    q5250::Field field2 = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 6 };
+    q5250::Field field3 = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 7 };
+    int fieldId1 = formatTable.append(field1);
+    formatTable.append(field2);
+    int fieldId3 = formatTable.append(field3);
+    formatTable.markAsModified(fieldId3);
+    formatTable.markAsModified(fieldId1);
+    formatTable.markAsModified(fieldId3);
+
+    formatTable.mapModified([&](const q5250::Field &field) {
+        rows.push_back(field.startRow);
+    });
+
+    ASSERT_THAT(rows, ElementsAre(5, 7));
+}
+
+TEST_F(ATerminalFormatTable, tracksFieldAppendedWithModifiedDataTag)
+{
+    unsigned count = 0;
+    q5250::Field field = { .format = 0x4800, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    formatTable.append(field);
+
+    formatTable.mapModified([&](const q5250::Field &) {
+        ++count;
+    });
+
+    ASSERT_THAT(count, Eq(1));
+}
+
+TEST_F(ATerminalFormatTable, skipsFieldWithResetModifiedDataTag)
+{
+    unsigned count = 0;
+    q5250::Field field = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    int fieldId = formatTable.append(field);
+    formatTable.markAsModified(fieldId);
+
+    formatTable.field(fieldId).format = 0x4000;
+    formatTable.mapModified([&](const q5250::Field &) {
+        ++count;
+    });
+
+    ASSERT_THAT(count, Eq(0));
+    ASSERT_FALSE(formatTable.isModified());
+}
+
+TEST_F(ATerminalFormatTable, forgetsModifiedFieldsOnClear)
+{
+    q5250::Field field = { .format = 0x4000, .attribute = 0x00, .length = 1, .startColumn = 5, .startRow = 5 };
+    formatTable.markAsModified(formatTable.append(field));
+
+    formatTable.clear();
+    formatTable.append(field);
+
+    ASSERT_FALSE(formatTable.isModified());
+}
+
+TEST_F(ATerminalFormatTable, makesNoHeapAllocationsWhenRefilledAfterClear)
+{
+    q5250::Field fields[16] = {};
+    for (const q5250::Field &field : fields) {
+        formatTable.append(field);
+    }
+    formatTable.clear();
+
+    AllocationCounter counter;
+    for (const q5250::Field &field : fields) {
+        formatTable.append(field);
+    }
+
+    ASSERT_THAT(counter.allocations(), Eq(0));
+}